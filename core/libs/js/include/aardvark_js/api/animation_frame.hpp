@@ -1,5 +1,6 @@
 #pragma once
 
+#include <aardvark/utils/profiler.hpp>
 #include <aardvark_jsi/jsi.hpp>
 #include <functional>
 #include <map>
@@ -8,8 +9,14 @@ namespace aardvark::js {
 
 class AnimationFrame {
   public:
-    int add_callback(std::function<void()> callback) {
+    using Callback = std::function<void(double timestamp)>;
+
+    // Called when the first callback is added after the previous frame
+    std::function<void()> request_frame_handler;
+
+    int add_callback(Callback callback) {
         id++;
+        if (callbacks.empty() && request_frame_handler) request_frame_handler();
         callbacks[id] = std::move(callback);
         return id;
     };
@@ -18,19 +25,22 @@ class AnimationFrame {
         callbacks.erase(id);
     };
 
-    void call_callbacks() {
+    // Timestamp is the time of the frame in milliseconds
+    void call_callbacks(double timestamp) {
+        auto profiler_scope = ProfilerScope("AnimationFrame::call_callbacks");
         // Copy because list of callbacks can be modified during the call
         auto copy = callbacks;
         callbacks.clear();
-        for (auto& it : copy) it.second();
+        for (auto& it : copy) it.second(timestamp);
     };
 
   private:
     int id = 0;
-    std::map<int, std::function<void()>> callbacks;
+    std::map<int, Callback> callbacks;
 };
 
-int request_animation_frame(jsi::Context& ctx, std::function<void()> callback);
+int request_animation_frame(
+    jsi::Context& ctx, std::function<void(double)> callback);
 
 void cancel_animation_frame(jsi::Context& ctx, int id);
 
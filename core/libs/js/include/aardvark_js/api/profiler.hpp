@@ -0,0 +1,18 @@
+#pragma once
+
+#include <aardvark_jsi/jsi.hpp>
+#include <string>
+
+namespace aardvark::js {
+
+void start_profiling(jsi::Context& ctx);
+
+void stop_profiling(jsi::Context& ctx);
+
+void clear_profiling(jsi::Context& ctx);
+
+std::string get_profiling_trace(jsi::Context& ctx);
+
+bool save_profiling_trace(jsi::Context& ctx, std::string path);
+
+}  // namespace aardvark::js
@@ -2,6 +2,7 @@ let path = require('path')
 let docgen = require('../../jsi/idl/docgen')
 
 let src = [
+    'animation',
     'animation_frame',
     'base_types',
     'events',
@@ -10,7 +11,8 @@ let src = [
     'document',
     'element',
     'elements',
-    'inline'
+    'inline',
+    'profiler'
 ]
 
 docgen({
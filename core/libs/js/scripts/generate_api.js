@@ -2,13 +2,15 @@ let path = require('path')
 let idl = require('../../jsi/idl')
 
 let src = [
+    'animation',
     'animation_frame',
     'base_types',
     'events',
     'document',
     'element',
     'elements',
-    'inline'
+    'inline',
+    'profiler'
 ]
 
 let desktop_src = [
@@ -27,6 +29,7 @@ idl({
     include: [
         '../include/aardvark_js/api/animation_frame.hpp',
         '../include/aardvark_js/api/element.hpp',
+        '../include/aardvark_js/api/profiler.hpp',
         '../include/aardvark_js/api/transform.hpp'
     ],
     output: {
@@ -47,6 +50,7 @@ idl({
     include: [
         '../include/aardvark_js/api/animation_frame.hpp',
         '../include/aardvark_js/api/element.hpp',
+        '../include/aardvark_js/api/profiler.hpp',
         '../include/aardvark_js/api/transform.hpp'
     ],
     output: {
@@ -1,5 +1,7 @@
 #include "android_host.hpp"
 
+#include <chrono>
+
 namespace aardvark::js {
 
 /*
@@ -91,7 +93,9 @@ AndroidHost::AndroidHost(
 }
 
 void AndroidHost::update() {
-    animation_frame.call_callbacks();
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    auto timestamp = std::chrono::duration<double, std::milli>(now).count();
+    animation_frame.call_callbacks(timestamp);
     app->update();
 }
 
@@ -10,7 +10,8 @@
 
 namespace aardvark::js {
 
-int request_animation_frame(jsi::Context& ctx, std::function<void()> callback) {
+int request_animation_frame(
+    jsi::Context& ctx, std::function<void(double)> callback) {
     auto host = static_cast<HOST_TYPE*>(ctx.user_pointer);
     return host->animation_frame.add_callback(std::move(callback));
 }
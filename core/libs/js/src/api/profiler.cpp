@@ -0,0 +1,21 @@
+#include "api/profiler.hpp"
+
+#include <aardvark/utils/profiler.hpp>
+
+namespace aardvark::js {
+
+void start_profiling(jsi::Context& ctx) { Profiler::enable(); }
+
+void stop_profiling(jsi::Context& ctx) { Profiler::disable(); }
+
+void clear_profiling(jsi::Context& ctx) { Profiler::clear(); }
+
+std::string get_profiling_trace(jsi::Context& ctx) {
+    return Profiler::get_chrome_trace();
+}
+
+bool save_profiling_trace(jsi::Context& ctx, std::string path) {
+    return Profiler::save_chrome_trace(path);
+}
+
+}  // namespace aardvark::js
@@ -43,6 +43,7 @@ Host::Host() {
 
     auto global = ctx->get_global_object();
     app = std::make_shared<DesktopApp>(event_loop);
+    animation_frame.request_frame_handler = [this]() { app->request_frame(); };
     global.set_property(
         "application", api->DesktopApp_mapper->to_js(*ctx, app));
     global.set_property("window", global.to_value());
@@ -79,7 +80,9 @@ Host::~Host() {
 void Host::run() {
     if (is_running) return;
     is_running = true;
-    app->run([&]() { animation_frame.call_callbacks(); });
+    app->run([&](double frame_time) {
+        animation_frame.call_callbacks(frame_time);
+    });
     event_loop->run();
 }
 
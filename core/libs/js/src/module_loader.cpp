@@ -3,21 +3,28 @@
 #include <aardvark/utils/log.hpp>
 #include <aardvark_jsi/jsi.hpp>
 #include <aardvark_jsi/mappers.hpp>
-#include <regex>
+#include <string_view>
 
 #if ADV_PLATFORM_DESKTOP
 #include <experimental/filesystem>
+#include <aardvark/utils/data_source.hpp>
 #include <aardvark/utils/files_utils.hpp>
 namespace fs = std::experimental::filesystem;
 #endif
 
 namespace aardvark::js {
 
-std::string get_source_map_url(const std::string& source) {
-    static auto re = std::regex("\n//# sourceMappingURL=(.+)$");
-    std::smatch match;
-    if (std::regex_search(source, match, re)) return match[1];
-    return "";
+// Source map url is specified by the comment on the last line. Only the end
+// of the source is searched, so it is fast for large bundles.
+std::string get_source_map_url(std::string_view source) {
+    static const auto prefix = std::string_view("\n//# sourceMappingURL=");
+    auto pos = source.rfind(prefix);
+    if (pos == std::string_view::npos) return "";
+    auto url = source.substr(pos + prefix.size());
+    if (url.empty() || url.find_first_of("\r\n") != std::string_view::npos) {
+        return "";
+    }
+    return std::string(url);
 }
 
 auto get_original_location_src = std::string(
@@ -64,7 +71,10 @@ jsi::Value ModuleLoader::load_from_file(const std::string& filepath) {
     // TODO check relative/absolute path
     auto full_filepath = fs::current_path().append(filepath);
     Log::info("[ModuleLoader] Load module from file {}", filepath);
-    auto source = utils::read_text_file(full_filepath);
+    // File is mapped, and it is copied only once, because JS engines need
+    // null-terminated source
+    auto data = MappedFile(full_filepath.string()).get_sk_data();
+    auto source = view_data(data);
     auto source_map = std::string();
     if (enable_source_maps) {
         auto source_map_url = get_source_map_url(source);
@@ -79,7 +89,8 @@ jsi::Value ModuleLoader::load_from_file(const std::string& filepath) {
                 source_map_path.u8string());
         }
     }
-    return ModuleLoader::load_from_source(source, full_filepath, source_map);
+    return ModuleLoader::load_from_source(
+        std::string(source), full_filepath, source_map);
 }
 #endif
 
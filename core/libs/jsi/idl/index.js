@@ -316,8 +316,8 @@ const functionInitTmpl = compileTmpl(`
         }
         {{/each}}
         {{#if return}}auto res = {{/if}}{{functionName}}(
-            *ctx,
-            {{#each args}}{{name}}_arg.value(){{#unless @last}}, {{/unless}}{{/each}}
+            *ctx{{#each args}},
+            {{name}}_arg.value(){{/each}}
         );
         {{#if return}}
         return {{return}}_mapper->to_js(*ctx, res);
@@ -433,6 +433,7 @@ const defaultTypes = {
     bool: 'bool',
     int: 'int',
     float: 'float',
+    double: 'double',
     string: 'std::string'
 }
 
@@ -450,6 +451,7 @@ const getPrefix = (def, options) => {
 }
 
 const setMappedType = (name, data, options) => {
+    if (name in defaultTypes) return
     let def = data.defs[name]
     if (def.mappedType !== undefined) return
     
@@ -485,13 +487,13 @@ const setMappedType = (name, data, options) => {
         let returnType = 'void'
         if ('return' in def) {
             setMappedType(def['return'], data, options)
-            returnType = data.defs[def['return']].mappedType
+            returnType = getMappedType(def['return'], data.defs)
         }
         let argTypes = ''
         if ('args' in def) {
             argTypes = def.args.map(arg => {
                 setMappedType(arg.type, data, options)
-                return data.defs[arg.type].mappedType
+                return getMappedType(arg.type, data.defs)
             }).join(', ')
         }
         def.mappedType = `std::function<${returnType}(${argTypes})>`
@@ -0,0 +1,79 @@
+#include "benchmark.hpp"
+
+#include <aardvark/layer.hpp>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+namespace aardvark::benchmarks {
+
+std::shared_ptr<Document> make_headless_document(Size size, float pixel_ratio) {
+    auto screen = Layer::make_raster_layer(size.scale(pixel_ratio));
+    auto document = std::make_shared<Document>(screen);
+    document->pixel_ratio = pixel_ratio;
+    return document;
+}
+
+BenchmarkResult run_frames(
+    const std::string& name,
+    Document* document,
+    int frames,
+    const FrameMutator& mutate) {
+    auto result = BenchmarkResult();
+    result.name = name;
+    // Initial render is not measured
+    document->render();
+    auto initial_misses = document->surface_pool.stats.misses;
+    for (auto frame = 0; frame < frames; frame++) {
+        if (mutate) mutate(frame);
+        auto start = std::chrono::steady_clock::now();
+        document->render();
+        auto end = std::chrono::steady_clock::now();
+        auto& timings = document->last_frame_timings;
+        result.layout_time += timings.layout;
+        result.paint_time += timings.paint;
+        result.compose_time += timings.compose;
+        result.composed_pixels += document->composed_pixels;
+        result.total_time +=
+            std::chrono::duration_cast<std::chrono::microseconds>(end - start)
+                .count();
+        result.frames++;
+    }
+    result.allocated_surfaces =
+        document->surface_pool.stats.misses - initial_misses;
+    return result;
+}
+
+double avg_ms(int64_t total_micros, int frames) {
+    return frames == 0 ? 0 : total_micros / 1000.0 / frames;
+}
+
+void print_result(const BenchmarkResult& result) {
+    auto fps = result.total_time == 0
+                   ? 0
+                   : result.frames / (result.total_time / 1000000.0);
+    std::cout << std::fixed << std::setprecision(3) << result.name << ": "
+              << result.frames << " frames, "
+              << "layout " << avg_ms(result.layout_time, result.frames)
+              << "ms, "
+              << "paint " << avg_ms(result.paint_time, result.frames) << "ms, "
+              << "compose " << avg_ms(result.compose_time, result.frames)
+              << "ms, "
+              << "frame " << avg_ms(result.total_time, result.frames) << "ms, "
+              << std::setprecision(1) << fps << " fps, "
+              << (result.frames == 0 ? 0
+                                     : result.composed_pixels / result.frames)
+              << " px composed, " << result.allocated_surfaces
+              << " surfaces allocated" << std::endl;
+}
+
+Color make_color(int seed) {
+    return Color{
+        (seed * 37) % 256,   // red
+        (seed * 73) % 256,   // green
+        (seed * 151) % 256,  // blue
+        255                  // alpha
+    };
+}
+
+}  // namespace aardvark::benchmarks
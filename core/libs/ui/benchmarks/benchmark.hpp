@@ -0,0 +1,68 @@
+#pragma once
+
+#include <aardvark/base_types.hpp>
+#include <aardvark/document.hpp>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace aardvark::benchmarks {
+
+// Accumulated results of rendering frames of a benchmark
+struct BenchmarkResult {
+    std::string name;
+    int frames = 0;
+    // Total durations of the phases in microseconds
+    int64_t layout_time = 0;
+    int64_t paint_time = 0;
+    int64_t compose_time = 0;
+    int64_t total_time = 0;
+    // Total number of recomposed screen pixels
+    int64_t composed_pixels = 0;
+    // Number of offscreen surfaces that were allocated for layers
+    int64_t allocated_surfaces = 0;
+};
+
+// Function that mutates the document before rendering a frame
+using FrameMutator = std::function<void(int frame)>;
+
+using Benchmark = std::function<BenchmarkResult(int frames)>;
+
+// Creates document that renders into the raster surface and does not require
+// GPU context.
+std::shared_ptr<Document> make_headless_document(
+    Size size, float pixel_ratio = 1);
+
+// Renders initial frame of the document, and then renders the specified
+// number of frames, calling `mutate` before each of them.
+BenchmarkResult run_frames(
+    const std::string& name,
+    Document* document,
+    int frames,
+    const FrameMutator& mutate);
+
+void print_result(const BenchmarkResult& result);
+
+// Makes opaque color that is deterministically derived from the seed
+Color make_color(int seed);
+
+// Document benchmarks
+BenchmarkResult grid_benchmark(int frames);
+BenchmarkResult flex_benchmark(int frames);
+BenchmarkResult dirty_rows_benchmark(int changed, int frames);
+BenchmarkResult cursor_benchmark(int frames);
+BenchmarkResult resize_benchmark(int frames);
+BenchmarkResult panes_benchmark(bool parallel, int frames);
+
+// Hit test benchmarks
+BenchmarkResult hit_test_benchmark(int elements, int frames);
+
+// Text benchmarks
+BenchmarkResult text_layout_benchmark(bool cold_font_cache, int frames);
+BenchmarkResult log_paragraph_benchmark(int frames);
+
+// Image benchmarks
+BenchmarkResult icon_grid_benchmark(bool use_atlas, int frames);
+
+}  // namespace aardvark::benchmarks
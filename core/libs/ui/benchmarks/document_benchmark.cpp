@@ -0,0 +1,232 @@
+#include <aardvark/elements/elements.hpp>
+
+#include "benchmark.hpp"
+
+namespace aardvark::benchmarks {
+
+// Grid of absolutely positioned colored cells, same as in the
+// `BenchmarkExample` of the JS examples. Every frame changes colors of some
+// of the cells.
+BenchmarkResult grid_benchmark(int frames) {
+    const auto rows = 40;
+    const auto cols = 40;
+    auto document = make_headless_document(Size{1000, 800});
+    auto backgrounds = std::vector<std::shared_ptr<BackgroundElement>>();
+    auto cells = std::vector<std::shared_ptr<Element>>();
+    for (auto row = 0; row < rows; row++) {
+        for (auto col = 0; col < cols; col++) {
+            auto bg = std::make_shared<BackgroundElement>(
+                nullptr, make_color(row * cols + col));
+            auto sized = std::make_shared<SizedElement>(
+                bg, SizeConstraints::exact(Value::abs(20), Value::abs(15)));
+            auto aligned = std::make_shared<AlignedElement>(
+                sized,
+                Alignment::top_left(
+                    Value::abs(row * 20),  // top
+                    Value::abs(col * 25)   // left
+                    ));
+            backgrounds.push_back(bg);
+            cells.push_back(aligned);
+        }
+    }
+    document->set_root(std::make_shared<StackElement>(cells));
+    return run_frames("grid", document.get(), frames, [&](int frame) {
+        for (auto i = frame % 10; i < backgrounds.size(); i += 10) {
+            auto color = make_color(frame + i);
+            backgrounds[i]->set_color(color);
+        }
+    });
+}
+
+// Rows of flex containers like in the `flex_example`. Every frame changes
+// sizes of the children, so the rows have to be relaid out.
+BenchmarkResult flex_benchmark(int frames) {
+    const auto rows = 100;
+    const auto children_count = 10;
+    auto document = make_headless_document(Size{1000, 800});
+    auto sized_children = std::vector<std::shared_ptr<SizedElement>>();
+    auto column_children = std::vector<std::shared_ptr<Element>>();
+    for (auto row = 0; row < rows; row++) {
+        auto children = std::vector<std::shared_ptr<Element>>();
+        for (auto i = 0; i < children_count; i++) {
+            auto sized = std::make_shared<SizedElement>(
+                std::make_shared<BackgroundElement>(
+                    nullptr, make_color(row * children_count + i)),
+                SizeConstraints::exact(Value::abs(20), Value::abs(6)));
+            sized_children.push_back(sized);
+            children.push_back(sized);
+        }
+        column_children.push_back(std::make_shared<FlexElement>(
+            children,
+            FlexDirection::row,
+            FlexJustify::space_between,
+            FlexAlign::center));
+    }
+    auto column = std::make_shared<FlexElement>(
+        column_children,
+        FlexDirection::column,
+        FlexJustify::start,
+        FlexAlign::stretch);
+    document->set_root(column);
+    return run_frames("flex", document.get(), frames, [&](int frame) {
+        for (auto i = frame % children_count; i < sized_children.size();
+             i += children_count) {
+            auto width = 10.0f + (frame + i) % 20;
+            auto constraints =
+                SizeConstraints::exact(Value::abs(width), Value::abs(6));
+            sized_children[i]->set_size_constraints(constraints);
+        }
+    });
+}
+
+// Long list of rows, where every row is a relayout boundary. Every frame
+// changes the specified number of rows, so time of the relayout should grow
+// linearly with the number of changed rows.
+BenchmarkResult dirty_rows_benchmark(int changed, int frames) {
+    const auto rows = 8000;
+    auto document = make_headless_document(Size{1000, 800});
+    auto backgrounds = std::vector<std::shared_ptr<BackgroundElement>>();
+    auto row_elems = std::vector<std::shared_ptr<Element>>();
+    for (auto row = 0; row < rows; row++) {
+        auto bg = std::make_shared<BackgroundElement>(nullptr, make_color(row));
+        auto sized = std::make_shared<SizedElement>(
+            bg, SizeConstraints::exact(Value::abs(200), Value::abs(1)));
+        row_elems.push_back(std::make_shared<AlignedElement>(
+            sized,
+            Alignment::top_left(
+                Value::abs(row % 800),  // top
+                Value::abs(0)           // left
+                )));
+        backgrounds.push_back(bg);
+    }
+    document->set_root(std::make_shared<StackElement>(row_elems));
+    auto name = "dirty_rows_" + std::to_string(changed);
+    return run_frames(name, document.get(), frames, [&](int frame) {
+        auto step = rows / changed;
+        for (auto i = frame % step; i < rows; i += step) {
+            auto color = make_color(frame + i);
+            backgrounds[i]->set_color(color);
+        }
+    });
+}
+
+// Static grid with a small blinking element that is a repaint boundary, like
+// a text cursor. Only the area of the cursor should be recomposed.
+BenchmarkResult cursor_benchmark(int frames) {
+    const auto rows = 40;
+    const auto cols = 40;
+    auto document = make_headless_document(Size{1000, 800});
+    auto children = std::vector<std::shared_ptr<Element>>();
+    for (auto row = 0; row < rows; row++) {
+        for (auto col = 0; col < cols; col++) {
+            children.push_back(std::make_shared<AlignedElement>(
+                std::make_shared<SizedElement>(
+                    std::make_shared<BackgroundElement>(
+                        nullptr, make_color(row * cols + col)),
+                    SizeConstraints::exact(Value::abs(20), Value::abs(15))),
+                Alignment::top_left(
+                    Value::abs(row * 20),  // top
+                    Value::abs(col * 25)   // left
+                    )));
+        }
+    }
+    auto cursor = std::make_shared<BackgroundElement>(
+        nullptr,
+        Color::black,
+        /* after */ false,
+        /* is_repaint_boundary */ true);
+    children.push_back(std::make_shared<AlignedElement>(
+        std::make_shared<SizedElement>(
+            cursor, SizeConstraints::exact(Value::abs(2), Value::abs(16))),
+        Alignment::top_left(Value::abs(100), Value::abs(100))));
+    document->set_root(std::make_shared<StackElement>(children));
+    return run_frames("cursor", document.get(), frames, [&](int frame) {
+        auto color = frame % 2 == 0 ? Color{255, 255, 255, 255} : Color::black;
+        cursor->set_color(color);
+    });
+}
+
+// Panel that is a repaint boundary and is expanded and collapsed every frame,
+// like during resize animation. Surfaces of the panel's layers should be
+// reused from the pool instead of being allocated every frame.
+BenchmarkResult resize_benchmark(int frames) {
+    const auto min_width = 200;
+    const auto max_width = 600;
+    auto document = make_headless_document(Size{1000, 800});
+    auto panel = std::make_shared<BackgroundElement>(
+        nullptr,
+        make_color(1),
+        /* after */ false,
+        /* is_repaint_boundary */ true);
+    auto sized = std::make_shared<SizedElement>(
+        panel, SizeConstraints::exact(Value::abs(min_width), Value::abs(400)));
+    document->set_root(std::make_shared<AlignedElement>(
+        sized, Alignment::top_left(Value::abs(100), Value::abs(100))));
+    return run_frames("resize", document.get(), frames, [&](int frame) {
+        // Width goes back and forth between min and max width
+        auto range = max_width - min_width;
+        auto offset = (frame * 7) % (range * 2);
+        auto width = min_width + (offset < range ? offset : range * 2 - offset);
+        sized->set_size_constraints(SizeConstraints::exact(
+            Value::abs(static_cast<float>(width)), Value::abs(400)));
+    });
+}
+
+// Grid of independent panes with rows of flex containers, like a multi-pane
+// dashboard. Every frame changes sizes of children in all panes, so many
+// disjoint relayout boundaries have to be laid out. With `parallel`, they are
+// laid out by the pool of layout threads.
+BenchmarkResult panes_benchmark(bool parallel, int frames) {
+    const auto pane_rows = 4;
+    const auto pane_cols = 4;
+    const auto rows = 40;
+    const auto children_count = 10;
+    auto document = make_headless_document(Size{1000, 800});
+    document->parallel_layout = parallel;
+    auto sized_children = std::vector<std::shared_ptr<SizedElement>>();
+    auto panes = std::vector<std::shared_ptr<Element>>();
+    for (auto pane = 0; pane < pane_rows * pane_cols; pane++) {
+        auto column_children = std::vector<std::shared_ptr<Element>>();
+        for (auto row = 0; row < rows; row++) {
+            auto children = std::vector<std::shared_ptr<Element>>();
+            for (auto i = 0; i < children_count; i++) {
+                auto sized = std::make_shared<SizedElement>(
+                    std::make_shared<BackgroundElement>(
+                        nullptr, make_color(row * children_count + i)),
+                    SizeConstraints::exact(Value::abs(15), Value::abs(4)));
+                sized_children.push_back(sized);
+                children.push_back(sized);
+            }
+            column_children.push_back(std::make_shared<FlexElement>(
+                children,
+                FlexDirection::row,
+                FlexJustify::space_between,
+                FlexAlign::center));
+        }
+        auto column = std::make_shared<FlexElement>(
+            column_children,
+            FlexDirection::column,
+            FlexJustify::start,
+            FlexAlign::stretch);
+        panes.push_back(std::make_shared<AlignedElement>(
+            std::make_shared<SizedElement>(
+                column,
+                SizeConstraints::exact(Value::abs(240), Value::abs(190))),
+            Alignment::top_left(
+                Value::abs((pane / pane_cols) * 200),  // top
+                Value::abs((pane % pane_cols) * 250)   // left
+                )));
+    }
+    document->set_root(std::make_shared<StackElement>(panes));
+    auto name = parallel ? "panes_parallel" : "panes";
+    return run_frames(name, document.get(), frames, [&](int frame) {
+        for (auto i = frame % 2; i < sized_children.size(); i += 2) {
+            auto width = 10.0f + (frame + i) % 10;
+            auto constraints =
+                SizeConstraints::exact(Value::abs(width), Value::abs(4));
+            sized_children[i]->set_size_constraints(constraints);
+        }
+    });
+}
+
+}  // namespace aardvark::benchmarks
@@ -0,0 +1,51 @@
+#include <aardvark/elements/elements.hpp>
+#include <aardvark/pointer_events/hit_tester.hpp>
+#include <chrono>
+
+#include "benchmark.hpp"
+
+namespace aardvark::benchmarks {
+
+// Grid of the specified number of cells. Every frame performs a single hit
+// test at a different point, so the frame time is the latency of the hit test.
+// Latency should grow much slower than the number of elements.
+BenchmarkResult hit_test_benchmark(int elements, int frames) {
+    const auto cols = 200;
+    auto document = make_headless_document(Size{1000, 800});
+    auto cells = std::vector<std::shared_ptr<Element>>();
+    for (auto i = 0; i < elements; i++) {
+        auto row = i / cols;
+        auto col = i % cols;
+        cells.push_back(std::make_shared<AlignedElement>(
+            std::make_shared<SizedElement>(
+                std::make_shared<BackgroundElement>(nullptr, make_color(i)),
+                SizeConstraints::exact(Value::abs(5), Value::abs(4))),
+            Alignment::top_left(
+                Value::abs(row * 4),  // top
+                Value::abs(col * 5)   // left
+                )));
+    }
+    document->set_root(std::make_shared<StackElement>(cells));
+    document->render();
+
+    auto hit_tester = HitTester(document.get());
+    // First test builds the index
+    hit_tester.test(0, 0);
+
+    auto result = BenchmarkResult();
+    result.name = "hit_test_" + std::to_string(elements);
+    for (auto frame = 0; frame < frames; frame++) {
+        auto left = static_cast<float>((frame * 37) % 1000);
+        auto top = static_cast<float>((frame * 53) % 800);
+        auto start = std::chrono::steady_clock::now();
+        hit_tester.test(left, top);
+        auto end = std::chrono::steady_clock::now();
+        result.total_time +=
+            std::chrono::duration_cast<std::chrono::microseconds>(end - start)
+                .count();
+        result.frames++;
+    }
+    return result;
+}
+
+}  // namespace aardvark::benchmarks
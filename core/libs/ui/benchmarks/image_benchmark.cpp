@@ -0,0 +1,56 @@
+#include <aardvark/elements/elements.hpp>
+
+#include "benchmark.hpp"
+
+namespace aardvark::benchmarks {
+
+std::shared_ptr<DataSource> make_icon_svg(int seed) {
+    auto size = std::to_string(8 + seed % 8);
+    return std::make_shared<StringSrc>(
+        "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"24\" "
+        "height=\"24\"><circle id=\"fill\" cx=\"12\" cy=\"12\" r=\"" +
+        size + "\" fill=\"gray\"/><rect x=\"6\" y=\"6\" width=\"" + size +
+        "\" height=\"4\" fill=\"black\"/></svg>");
+}
+
+// Grid of 1000 small SVG icons, like in the file browser. Every frame changes
+// color of one of the icons, so the whole grid is repainted. Icons are drawn
+// either one by one from the rasters, or in batches from the icon atlas.
+BenchmarkResult icon_grid_benchmark(bool use_atlas, int frames) {
+    const auto rows = 25;
+    const auto cols = 40;
+    const auto sources = 20;
+    auto document = make_headless_document(Size{1000, 800});
+    auto srcs = std::vector<std::shared_ptr<DataSource>>();
+    for (auto i = 0; i < sources; i++) srcs.push_back(make_icon_svg(i));
+    auto icons = std::vector<std::shared_ptr<SvgImageElement>>();
+    auto cells = std::vector<std::shared_ptr<Element>>();
+    for (auto row = 0; row < rows; row++) {
+        for (auto col = 0; col < cols; col++) {
+            auto icon = std::make_shared<SvgImageElement>(
+                srcs[(row * cols + col) % sources], ImageFit::contain);
+            icon->raster_cache = true;
+            icon->use_icon_atlas = use_atlas;
+            auto sized = std::make_shared<SizedElement>(
+                icon, SizeConstraints{Value::abs(24), Value::abs(24)});
+            auto aligned = std::make_shared<AlignedElement>(
+                sized,
+                Alignment::top_left(
+                    Value::abs(row * 32),  // top
+                    Value::abs(col * 25)   // left
+                    ));
+            icons.push_back(icon);
+            cells.push_back(aligned);
+        }
+    }
+    document->set_root(std::make_shared<StackElement>(cells));
+    auto name = use_atlas ? "icon_grid_atlas" : "icon_grid";
+    return run_frames(name, document.get(), frames, [&](int frame) {
+        auto& icon = icons[frame * 7 % icons.size()];
+        auto color_map = ColorMap();
+        if (frame % 2 == 0) color_map["fill"] = make_color(frame % 4);
+        icon->set_color_map(color_map);
+    });
+}
+
+}  // namespace aardvark::benchmarks
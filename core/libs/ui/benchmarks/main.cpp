@@ -0,0 +1,62 @@
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "benchmark.hpp"
+
+using namespace aardvark::benchmarks;
+
+// Usage: adv_ui_benchmarks [name] [frames]
+int main(int argc, char** argv) {
+    auto benchmarks = std::vector<std::pair<std::string, Benchmark>>{
+        {"grid", grid_benchmark},
+        {"flex", flex_benchmark},
+        {"cursor", cursor_benchmark},
+        {"resize", resize_benchmark},
+        {"panes", [](int frames) { return panes_benchmark(false, frames); }},
+        {"panes_parallel",
+         [](int frames) { return panes_benchmark(true, frames); }},
+        {"text_layout",
+         [](int frames) { return text_layout_benchmark(false, frames); }},
+        {"text_layout_cold",
+         [](int frames) { return text_layout_benchmark(true, frames); }},
+        {"log_paragraph", log_paragraph_benchmark},
+        {"icon_grid",
+         [](int frames) { return icon_grid_benchmark(false, frames); }},
+        {"icon_grid_atlas",
+         [](int frames) { return icon_grid_benchmark(true, frames); }},
+    };
+    // Relayout of changed rows should scale linearly
+    for (auto changed : {250, 500, 1000, 2000, 4000}) {
+        benchmarks.emplace_back(
+            "dirty_rows_" + std::to_string(changed),
+            [changed](int frames) {
+                return dirty_rows_benchmark(changed, frames);
+            });
+    }
+
+    // Latency of the hit test should grow slower than number of elements
+    for (auto elements : {1000, 5000, 20000}) {
+        benchmarks.emplace_back(
+            "hit_test_" + std::to_string(elements),
+            [elements](int frames) {
+                return hit_test_benchmark(elements, frames);
+            });
+    }
+
+    auto filter = argc > 1 ? std::string(argv[1]) : std::string("all");
+    auto frames = argc > 2 ? std::stoi(argv[2]) : 300;
+
+    auto found = false;
+    for (auto& [name, benchmark] : benchmarks) {
+        if (filter != "all" && filter != name) continue;
+        found = true;
+        print_result(benchmark(frames));
+    }
+    if (!found) {
+        std::cerr << "Unknown benchmark: " << filter << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,84 @@
+#include <aardvark/elements/elements.hpp>
+#include <aardvark/inline_layout/decoration_span.hpp>
+#include <aardvark/inline_layout/font_cache.hpp>
+#include <aardvark/inline_layout/text_span.hpp>
+
+#include "benchmark.hpp"
+
+namespace aardvark::benchmarks {
+
+// Column of paragraphs and labels whose width changes every frame, so all
+// text has to be laid out again. With `cold_font_cache`, the font cache is
+// cleared before each frame, so fonts are loaded from the font manager as
+// when they were not cached.
+BenchmarkResult text_layout_benchmark(bool cold_font_cache, int frames) {
+    const auto paragraphs = 20;
+    const auto spans = 20;
+    const auto labels = 200;
+    const auto min_width = 300;
+    const auto max_width = 900;
+    auto document = make_headless_document(Size{1000, 800});
+    auto style = TextStyle();
+    auto text = UnicodeString(
+        (UChar*)u"The quick brown fox jumps over the lazy dog. ");
+    auto children = std::vector<std::shared_ptr<Element>>();
+    for (auto i = 0; i < paragraphs; i++) {
+        auto span_list = std::vector<std::shared_ptr<inline_layout::Span>>();
+        for (auto j = 0; j < spans; j++) {
+            span_list.push_back(
+                std::make_shared<inline_layout::TextSpan>(text, style));
+        }
+        children.push_back(std::make_shared<ParagraphElement>(
+            std::make_shared<inline_layout::DecorationSpan>(span_list),
+            style.get_metrics()));
+    }
+    for (auto i = 0; i < labels; i++) {
+        children.push_back(std::make_shared<TextElement>(text, style));
+    }
+    auto column = std::make_shared<FlexElement>(
+        children, FlexDirection::column, FlexJustify::start, FlexAlign::start);
+    auto sized = std::make_shared<SizedElement>(
+        column,
+        SizeConstraints::exact(Value::abs(min_width), Value::abs(800)));
+    document->set_root(sized);
+    auto name = cold_font_cache ? "text_layout_cold" : "text_layout";
+    return run_frames(name, document.get(), frames, [&](int frame) {
+        if (cold_font_cache) inline_layout::FontCache::clear();
+        auto range = max_width - min_width;
+        auto offset = (frame * 13) % (range * 2);
+        auto width = min_width + (offset < range ? offset : range * 2 - offset);
+        sized->set_size_constraints(SizeConstraints::exact(
+            Value::abs(static_cast<float>(width)), Value::abs(800)));
+    });
+}
+
+// Paragraph with a long log, where one character is typed at the end of the
+// last line every frame. Only the last line should be laid out again.
+BenchmarkResult log_paragraph_benchmark(int frames) {
+    const auto log_lines = 5000;
+    auto document = make_headless_document(Size{1000, 800});
+    auto style = TextStyle();
+    auto span_list = std::vector<std::shared_ptr<inline_layout::Span>>();
+    for (auto i = 0; i < log_lines; i++) {
+        auto text = "[" + std::to_string(i) + "] Request completed in " +
+                    std::to_string(i % 97) + "ms";
+        span_list.push_back(std::make_shared<inline_layout::TextSpan>(
+            UnicodeString::fromUTF8(text), style));
+    }
+    auto last_span = std::make_shared<inline_layout::TextSpan>(
+        UnicodeString(), style);
+    span_list.push_back(last_span);
+    auto paragraph = std::make_shared<ParagraphElement>(
+        std::make_shared<inline_layout::DecorationSpan>(span_list),
+        style.get_metrics());
+    document->set_root(std::make_shared<StackElement>(
+        std::vector<std::shared_ptr<Element>>{paragraph}));
+    auto typed = std::string();
+    return run_frames("log_paragraph", document.get(), frames, [&](int frame) {
+        typed.push_back('a' + frame % 26);
+        last_span->set_text(typed);
+        paragraph->change();
+    });
+}
+
+}  // namespace aardvark::benchmarks
@@ -6,7 +6,7 @@
 
 int main() {
     auto event_loop = aardvark::EventLoop();
-    auto ws = std::make_shared<aardvark::Websocket>(event_loop.io,
+    auto ws = std::make_shared<aardvark::Websocket>(event_loop,
                                                     "echo.websocket.org", "80");
     ws->open_signal.connect([ws](){
         std::cout << "open" << std::endl;
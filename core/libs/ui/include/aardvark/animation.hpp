@@ -0,0 +1,69 @@
+#pragma once
+
+#include <functional>
+#include <limits>
+
+namespace aardvark {
+
+// Compose properties of the layer tree that can be animated natively
+enum class AnimatedProperty {
+    opacity,
+    translate_left,
+    translate_top,
+    scale,
+    rotation
+};
+
+enum class AnimationType { timing, spring, decay };
+
+enum class AnimationEasing { linear, ease_in, ease_out, ease_in_out };
+
+struct AnimationOptions {
+    AnimationType type = AnimationType::timing;
+    // Start value. When it is NaN, animation starts from the current value of
+    // the property.
+    float from = std::numeric_limits<float>::quiet_NaN();
+    // End value, not used by decay
+    float to = 0;
+    // Initial velocity in units per second, used by spring and decay
+    float velocity = 0;
+    // Duration in milliseconds and easing of timing animation
+    float duration = 300;
+    AnimationEasing easing = AnimationEasing::ease_in_out;
+    // Parameters of spring animation
+    float stiffness = 100;
+    float damping = 10;
+    float mass = 1;
+    // Rate of decay of velocity per millisecond
+    float deceleration = 0.998;
+    // Spring and decay animations end when they are closer than this to the
+    // end value and move slower than this per second
+    float rest_threshold = 0.001;
+};
+
+// Called when animation is finished or stopped. `finished` is `false` when the
+// animation was stopped before reaching its end.
+using AnimationCallback = std::function<void(bool finished)>;
+
+// Calculates value of the animated property over time
+class Animation {
+  public:
+    Animation(const AnimationOptions& options, float from);
+
+    // Returns value at the specified time in milliseconds since the start
+    float value_at(double time);
+
+    // Whether the last returned value is the final value
+    bool is_done = false;
+
+  private:
+    AnimationOptions options;
+    float from;
+
+    float timing_value_at(double time);
+    float spring_value_at(double time);
+    float decay_value_at(double time);
+    float spring_position(double seconds);
+};
+
+}  // namespace aardvark
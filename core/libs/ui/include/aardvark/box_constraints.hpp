@@ -24,6 +24,17 @@ struct BoxConstraints {
 
     // Makes tight or loose constraints from size
     static BoxConstraints from_size(Size size, bool tight);
+
+    static bool is_equal(BoxConstraints a, BoxConstraints b);
 };
 
+inline bool operator==(const BoxConstraints& lhs, const BoxConstraints& rhs) {
+    return lhs.min_width == rhs.min_width && lhs.max_width == rhs.max_width &&
+           lhs.min_height == rhs.min_height && lhs.max_height == rhs.max_height;
+}
+
+inline bool operator!=(const BoxConstraints& lhs, const BoxConstraints& rhs) {
+    return !(lhs == rhs);
+}
+
 } // namespace aardvark
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "SkCanvas.h"
+#include "SkMatrix.h"
+#include "SkPath.h"
+#include "SkRRect.h"
+#include "SkRect.h"
+
+namespace aardvark {
+
+// Clip area that keeps rect and rounded rect forms, so most clips can be
+// intersected, transformed and tested without converting them to paths.
+class Clip {
+  public:
+    enum class Type { rect, rrect, path };
+
+    Clip() : Clip(SkRect::MakeEmpty()){};
+    Clip(const SkRect& rect) : type(Type::rect), rect(rect){};
+    Clip(const SkRRect& rrect);
+    // Detects whether the path is rect, rounded rect or oval
+    Clip(const SkPath& path);
+
+    static Clip make_rect(const SkRect& rect) { return Clip(rect); };
+    static Clip make_rrect(const SkRRect& rrect) { return Clip(rrect); };
+    static Clip make_path(const SkPath& path) { return Clip(path); };
+
+    Type get_type() const { return type; };
+
+    // Bounding rect of the clip, for rects it is the clip itself
+    SkRect get_bounds() const;
+
+    SkPath to_path() const;
+
+    Clip offset(float left, float top) const;
+
+    Clip intersect(const Clip& other) const;
+
+    // Rect and rounded rect stay the same type when the matrix only
+    // translates and scales
+    Clip transform(const SkMatrix& matrix) const;
+
+    bool contains(float left, float top) const;
+
+    // Intersects the canvas clip with this clip
+    void apply(SkCanvas* canvas, bool antialias = true) const;
+
+  private:
+    // Offset or transformed path is not checked again for simpler forms
+    static Clip make_exact_path(const SkPath& path);
+
+    Type type;
+    SkRect rect;
+    SkRRect rrect;
+    SkPath path;
+};
+
+}  // namespace aardvark
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <queue>
+#include <unordered_set>
+#include <vector>
+
+namespace aardvark {
+
+class Element;
+
+// Queue of dirty elements that returns them ordered by their depth in the tree,
+// so ancestors are always processed before their descendants. Elements with
+// the same depth are returned in the order they were added.
+class DirtyQueue {
+  public:
+    // Adds element to the queue, does nothing if it is already queued
+    void push(Element* elem, int depth);
+
+    // Removes and returns the element with the smallest depth
+    Element* pop();
+
+    bool empty() const { return heap.empty(); };
+    int size() const { return heap.size(); };
+    void clear();
+
+  private:
+    struct Entry {
+        int depth;
+        int order;
+        Element* elem;
+    };
+
+    struct EntryCompare {
+        bool operator()(const Entry& a, const Entry& b) const {
+            if (a.depth != b.depth) return a.depth > b.depth;
+            return a.order > b.order;
+        }
+    };
+
+    std::priority_queue<Entry, std::vector<Entry>, EntryCompare> heap;
+    std::unordered_set<Element*> queued;
+    int order = 0;
+};
+
+}  // namespace aardvark
@@ -1,26 +1,40 @@
 #pragma once
 
+#include <chrono>
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "GrDirectContext.h"
 #include "SkCanvas.h"
+#include "SkPictureRecorder.h"
+#include "SkRSXform.h"
 #include "SkRegion.h"
+#include "animation.hpp"
 #include "base_types.hpp"
 #include "box_constraints.hpp"
+#include "clip.hpp"
+#include "dirty_queue.hpp"
 #include "element.hpp"
 #include "element_observer.hpp"
+#include "icon_atlas.hpp"
 #include "layer.hpp"
 #include "layer_tree.hpp"
 #include "pointer_events/pointer_event_manager.hpp"
 #include "pointer_events/signal_event_sink.hpp"
+#include "surface_pool.hpp"
+#include "utils/work_stealing_pool.hpp"
 
 namespace aardvark {
 
 // forward declaration due to circular includes
 class Element;
+class EventLoop;
 class LayerTree;
 class PointerEventManager;
 
@@ -29,6 +43,65 @@ using ElementsSet = std::unordered_set<Element*>;
 
 using LayerTreeNode = std::variant<LayerTree*, std::shared_ptr<Layer>>;
 
+// Durations of the rendering phases of a frame in microseconds
+struct FrameTimings {
+    int64_t layout = 0;
+    int64_t paint = 0;
+    int64_t compose = 0;
+};
+
+// Amounts of work done during a frame
+struct FrameCounters {
+    int elements_laid_out = 0;
+    int elements_painted = 0;
+    int layers_created = 0;
+    int layers_reused = 0;
+    int relayout_boundaries = 0;
+    // Elements that reused result of previous layout
+    int layouts_skipped = 0;
+    int repaint_boundaries = 0;
+    // Elements that were painted by replaying their display lists
+    int display_lists_replayed = 0;
+    int repaint_boundaries_promoted = 0;
+    int repaint_boundaries_demoted = 0;
+    // Icons that were drawn from the icon atlas, and `drawAtlas` calls that
+    // drew them
+    int icons_drawn = 0;
+    int icon_batches = 0;
+};
+
+// Thresholds for automatic promotion of elements to repaint boundaries and
+// demotion of repaint boundaries. Repaints are counted during the window of
+// the specified number of paint passes.
+struct RepaintBoundaryTuning {
+    bool enabled = true;
+    int window = 60;
+    // Element is promoted when its changes caused at least this many repaints
+    // during the window, and its area is not bigger than the specified part of
+    // the area of its current boundary.
+    int promote_min_changes = 10;
+    float promote_max_area_ratio = 0.25;
+    // Limit of the number of promoted boundaries in the document
+    int max_promoted = 64;
+    // Boundary is demoted when it was repainted at least this many times
+    // during the window, and at least the specified part of the repaints
+    // happened as part of the repaint of its parent boundary.
+    int demote_min_repaints = 10;
+    float demote_min_ratio = 0.9;
+};
+
+// Totals of the automatic changes of repaint boundaries
+struct RepaintBoundaryStats {
+    int promotions = 0;
+    int demotions = 0;
+    // Currently promoted boundaries
+    int promoted = 0;
+    // Bytes of the layers of demoted boundaries that are no longer allocated
+    int64_t layer_bytes_saved = 0;
+    // Bytes of the layers allocated for promoted boundaries
+    int64_t layer_bytes_added = 0;
+};
+
 class Document : public std::enable_shared_from_this<Document> {
   public:
     Document(
@@ -36,22 +109,75 @@ class Document : public std::enable_shared_from_this<Document> {
         std::shared_ptr<Layer> screen,
         std::shared_ptr<Element> root = nullptr);
 
+    // Creates document without GPU context. Layers of such document are backed
+    // by raster surfaces, so it can be rendered headless, for example, in
+    // tests and benchmarks.
+    Document(
+        std::shared_ptr<Layer> screen, std::shared_ptr<Element> root = nullptr);
+
     // Sets new root element
     void set_root(std::shared_ptr<Element> new_root);
 
-    // Notify document that element has been changed
+    // Notify document that element has been changed. Can be called from the
+    // layout threads.
     void change_element(Element* elem);
 
     // Notify document that layer properties have beed changed
-    void change_layer(Element* elem) { need_recompose = true; };
+    void change_layer(Element* elem);
 
-    // Renders document
+    // Renders document. Returns `true` when the screen was updated.
     bool render();
 
+    // Marks the whole screen as damaged, so it will be recomposed during the
+    // next frame, for example, when contents of the window were lost.
+    void invalidate_screen();
+
+    // Called when document needs to render a new frame. It is set by the
+    // platform to schedule frames only when something is changed.
+    std::function<void()> request_frame_handler;
+
+    void request_frame();
+
+    // Loop of the thread that renders the document. Elements use it to receive
+    // results of the background work, without it the work is done on the
+    // rendering thread.
+    EventLoop* event_loop = nullptr;
+
     void relayout();
 
     float pixel_ratio = 2;
 
+    // Changes pixel ratio of the document. Root is laid out again at the size
+    // of the screen in the new logical pixels, and layers are rasterized again
+    // by replaying display lists of the elements whose layout is not changed,
+    // without calling their `paint`.
+    void set_pixel_ratio(float ratio);
+
+    // Elements that repaint often separately from the rest of their boundary
+    // are promoted to repaint boundaries, and boundaries that are always
+    // repainted together with their parent are demoted.
+    RepaintBoundaryTuning repaint_boundary_tuning;
+    RepaintBoundaryStats repaint_boundary_stats;
+
+    // When enabled, painting of the elements is recorded into display lists,
+    // and unchanged elements are replayed instead of being painted again.
+    bool record_display_lists = true;
+
+    // Starts animation of the compose property of the layer tree of the
+    // element. Animations are updated by the document before each frame
+    // without relayout or repaint, so only composition is performed. Element
+    // becomes repaint boundary if it is not already. Previous animation of
+    // the same property of the element is stopped. Returns id of the
+    // animation.
+    int start_animation(
+        std::shared_ptr<Element> elem,
+        AnimatedProperty property,
+        const AnimationOptions& options,
+        AnimationCallback callback = nullptr);
+
+    // Stops animation, property keeps its current value
+    void stop_animation(int id);
+
     // Makes the layout of the specified element up-to-date by performing
     // partial relayout of the document.
     void partial_relayout(Element* elem);
@@ -66,16 +192,30 @@ class Document : public std::enable_shared_from_this<Document> {
     // Elements should call this function to paint its children
     void paint_element(Element* elem, bool is_repaint_root = false);
 
-    // Elements should call this method to obtain layer to paint itself
+    // Elements should call this method to obtain canvas to paint itself.
+    // Canvas is translated to the position of the element and clipped.
+    // Painting is recorded into the display list of the element that is
+    // currently painted.
+    SkCanvas* get_canvas(Element* elem);
+
+    // Returns layer to paint directly into it, bypassing display lists
     Layer* get_layer();
 
     // Sets translate and clip for painting element on the layer
     void setup_layer(Layer* layer, Element* elem);
 
     // Creates layer and adds it to the current layer tree, reusing layers from
-    // previous repaint if possible.
+    // previous repaint or surfaces from the pool if possible.
     Layer* create_layer(Size size);
 
+    // Draws image from the icon atlas into the rect in the coordinates of the
+    // element. Icons are collected and drawn into the layer in batches,
+    // before anything else is painted into the layer. Elements that contain
+    // icons paint directly into the layer instead of recording display
+    // lists. Returns false when the image can not be placed in the atlas,
+    // then element should paint it by itself.
+    bool draw_icon(Element* elem, const sk_sp<SkImage>& image, SkRect rect);
+
     std::shared_ptr<Connection> add_pointer_event_handler(
         const PointerEventHandler& handler, const bool after_elements = false);
 
@@ -101,6 +241,38 @@ class Document : public std::enable_shared_from_this<Document> {
     bool is_initial_render;
     bool need_recompose = false;
 
+    // Timings of the last rendered frame
+    FrameTimings last_frame_timings;
+
+    // Counters of the last rendered frame
+    FrameCounters last_frame_counters;
+
+    // When enabled, only damaged area of the screen is recomposed. This
+    // requires the screen surface to preserve its contents between frames,
+    // which is true for raster surfaces, but not for the most of the GL
+    // window framebuffers. When disabled, whole screen is recomposed, but
+    // composition is still skipped when nothing is damaged.
+    bool partial_compose = false;
+
+    // When enabled, relayout boundaries that are not inside of each other are
+    // laid out in parallel by the pool of layout threads. In this mode,
+    // elements should not access elements outside of their subtree during
+    // layout. Results of the layout are the same as in the sequential mode.
+    bool parallel_layout = false;
+
+    // Damaged rects of the screen that were recomposed during the last frame
+    std::vector<SkIRect> damage_rects;
+
+    // Number of screen pixels that were recomposed during the last frame
+    int64_t composed_pixels = 0;
+
+    // Surfaces of the layers that are no longer used are returned here to be
+    // reused by any repaint boundary of the document
+    SurfacePool surface_pool;
+
+    // Atlas of the icons that are drawn using `draw_icon`
+    IconAtlas icon_atlas;
+
     std::unique_ptr<PointerEventManager> pointer_event_manager;
     SignalEventSink<KeyEvent> key_event_sink;
     SignalEventSink<CharEvent> char_event_sink;
@@ -108,19 +280,72 @@ class Document : public std::enable_shared_from_this<Document> {
 
   private:
     bool initial_render();
+    void record_frame_counters();
     bool rerender();
+    Element* mark_needs_layout(Element* elem);
     void relayout_boundary_element(Element* elem);
-    void reset_intrinsic_queried(Element* elem);
+    void relayout_boundaries_parallel();
+    void finish_boundary_relayout(Element* elem);
+    void relayout_root();
+    bool clear_changed_display_lists(Element* elem, Element* boundary);
+    FrameCounters& get_layout_counters();
+    void update_tree_depth(Element* elem, int depth);
     void update_tree_abs_position(Element* elem);
     void update_abs_position(Element* elem);
     bool repaint();
-    void compose();
+    void release_layers(std::vector<LayerTreeNode>& nodes);
+    void paint_directly(Element* elem);
+    void flush_icons();
+    void start_recording(Element* elem);
+    sk_sp<SkPicture> finish_recording();
+    void flush_recordings();
+    void draw_display_list(const sk_sp<SkPicture>& display_list);
+    void count_repaint(Element* elem, bool is_repaint_root);
+    void update_repaint_boundaries();
+    bool can_promote(Element* elem);
+    bool can_demote(Element* elem);
+    void make_repaint_boundary(Element* elem);
+    void promote_repaint_boundary(Element* elem);
+    void demote_repaint_boundary(Element* elem);
+    int64_t get_layer_bytes(Element* elem);
+    void update_animations();
+    bool compose();
     void paint_layer_tree(LayerTree* tree);
+    SkRegion collect_damage();
+    void collect_layer_tree_damage(
+        LayerTree* tree,
+        const SkMatrix& parent_matrix,
+        const SkRect& parent_clip_bounds,
+        float parent_opacity,
+        bool parent_changed,
+        SkRegion* damage);
+
+    // Bounds and opacity of the layer tree on the screen during composition
+    struct ComposedLayerTree {
+        SkRect bounds;
+        float opacity;
+    };
+
+    struct RunningAnimation {
+        int id;
+        std::weak_ptr<Element> elem;
+        AnimatedProperty property;
+        Animation animation;
+        AnimationCallback callback;
+        // Animation starts at the first frame after it was started
+        std::optional<std::chrono::steady_clock::time_point> start_time;
+    };
 
     sk_sp<GrDirectContext> gr_context;
+    std::vector<RunningAnimation> animations;
+    int next_animation_id = 1;
     ElementsSet changed_elements;
-    ElementsSet relayout_boundaries;
-    ElementsSet repaint_boundaries;
+    std::mutex changed_elements_mutex;
+    std::unique_ptr<WorkStealingPool> layout_pool;
+    DirtyQueue relayout_boundaries;
+    DirtyQueue repaint_boundaries;
+    int layout_pass = 0;
+    int paint_pass = 0;
     // Currently painted element
     Element* current_element = nullptr;
     // Layer tree of the current repaint boundary element
@@ -129,11 +354,39 @@ class Document : public std::enable_shared_from_this<Document> {
     std::vector<LayerTreeNode> layers_pool;
     // Layer that is currently used for painting
     Layer* current_layer = nullptr;
-    std::optional<SkPath> current_clip = std::nullopt;
+    // Display lists of the elements of the current repaint boundary that are
+    // being recorded, from outer to inner
+    struct DisplayListRecording {
+        Element* elem;
+        SkPictureRecorder recorder;
+        SkCanvas* canvas;
+    };
+    std::vector<std::unique_ptr<DisplayListRecording>> recordings;
+    // Elements that reached thresholds for promotion or demotion during the
+    // previous paint passes
+    std::vector<std::weak_ptr<Element>> repaint_boundary_candidates;
+    // Clip of the current element in absolute coordinates
+    std::optional<Clip> current_clip = std::nullopt;
+    // Icons that are not drawn yet, by pages of the atlas
+    struct IconBatch {
+        std::shared_ptr<IconAtlasPage> page;
+        std::vector<SkRSXform> xforms;
+        std::vector<SkRect> rects;
+    };
+    std::vector<IconBatch> icon_batches;
+    // Icons are flushed when the clip is changed, so all of them have the
+    // same clip
+    std::optional<Clip> icon_batches_clip = std::nullopt;
     // Whether the current element or some of its parent is changed since last
     // repaint
     bool inside_changed = false;
     float current_opacity = 1;
+    // Layer trees composed during the previous and the current frame
+    std::unordered_map<LayerTree*, ComposedLayerTree> prev_composed_trees;
+    std::unordered_map<LayerTree*, ComposedLayerTree> composed_trees;
+    bool need_full_compose = true;
+    // Root should be laid out at the new size of the screen
+    bool need_root_relayout = false;
     std::shared_ptr<ElementObserver<Size>> size_observer;
 };
 
@@ -5,10 +5,12 @@
 #include <optional>
 #include <string>
 
-#include "SkPath.h"
+#include "SkPicture.h"
 #include "base_types.hpp"
 #include "box_constraints.hpp"
+#include "clip.hpp"
 #include "document.hpp"
+#include "intrinsic_size_cache.hpp"
 #include "pointer_events/hit_tester.hpp"
 #include "pointer_events/responder.hpp"
 
@@ -32,6 +34,7 @@ namespace aardvark {
 class Document;
 class LayerTree;
 class HitTester;
+struct BoundaryHitTestIndex;
 
 enum class HitTestMode {
     // After element handles event, it passes it to the element that is behind.
@@ -51,6 +54,25 @@ enum class HitTestMode {
 
 using ChildrenVisitor = std::function<void(std::shared_ptr<Element>&)>;
 
+// Repaints of the element counted by the document during the current window
+// of paint passes
+struct RepaintStats {
+    // Paint pass when the current window started
+    int window_start = 0;
+    // Repaints caused by changes of the element itself
+    int changes = 0;
+    // Repaints of the boundary as the root of the repaint
+    int repaints_alone = 0;
+    // Repaints of the boundary as part of the parent boundary
+    int repaints_with_parent = 0;
+    // Element is already scheduled for promotion or demotion
+    bool is_candidate = false;
+    // Element was promoted to repaint boundary by the document
+    bool is_promoted = false;
+    // Demoted elements are not promoted again
+    bool is_demoted = false;
+};
+
 // Base class for elements of the document
 class Element : public std::enable_shared_from_this<Element> {
     friend Document;
@@ -69,6 +91,11 @@ class Element : public std::enable_shared_from_this<Element> {
     // This allows to repaint this element separately.
     bool is_repaint_boundary;
 
+    // When `true`, the document never changes `is_repaint_boundary` of this
+    // element, for example, because it needs separate layer to apply
+    // transform or opacity.
+    bool is_repaint_boundary_fixed = false;
+
     // Should be `true` when its size depends only on input constraints, not on
     // element's props or children. This allows to optimize relayout.
     bool size_depends_on_parent;
@@ -92,19 +119,15 @@ class Element : public std::enable_shared_from_this<Element> {
     // Returns minimum width that element could fit into.
     virtual float get_intrinsic_width(float height) { return 0; }
 
-    // Flag that tracks when intrinsic size of this element was queried during
-    // last layout
+    // Flag that tracks when intrinsic size of this element was queried since
+    // its last layout
     bool intrinsic_queried = false;
 
-    float query_intrinsic_height(float width) {
-        intrinsic_queried = true;
-        return get_intrinsic_height(width);
-    }
-
-    float query_intrinsic_width(float height) {
-        intrinsic_queried = true;
-        return get_intrinsic_width(height);
-    }
+    // Parent elements should use these methods to get intrinsic size of the
+    // children. Results are cached until the element or some of its
+    // descendants is changed.
+    float query_intrinsic_height(float width);
+    float query_intrinsic_width(float height);
 
     // Paints element and its children.
     // `is_changed` is `true` when the element itself or some of its parents is
@@ -120,6 +143,7 @@ class Element : public std::enable_shared_from_this<Element> {
     };
 
     // Checks if element is hit by pointer. Default is checking element's box.
+    // It is only called for points inside of the element's box.
     virtual bool hit_test(double left, double top);
 
     // Default is `PassToParent`.
@@ -141,11 +165,19 @@ class Element : public std::enable_shared_from_this<Element> {
     // -------------------------------------------------------------------------
     Size size;
     Position rel_position = Position{0, 0};
-    std::optional<SkPath> clip = std::nullopt;
+    std::optional<Clip> clip = std::nullopt;
 
     // Notifies the document, that this element was changed
     void change();
 
+    // Clears cached intrinsic sizes of the element and its ancestors
+    void invalidate_intrinsic_size();
+
+    // Makes the next layout of the element not reuse the previous result.
+    // Containers call this during own layout on the child elements that they
+    // reuse with new props, instead of notifying the document.
+    void invalidate_layout();
+
     // Checks whether the element is direct or indirect parent of another
     // element
     bool is_parent_of(Element* elem);
@@ -171,7 +203,7 @@ class Element : public std::enable_shared_from_this<Element> {
   private:
     // Whether the element was changed by updating props or performig relayout
     // since last repaint.
-    bool is_changed;
+    bool is_changed = true;
 
     // When element is relayout boundary, changes inside it do not affect
     // layout of parents. This happens when element recieves tight constraints,
@@ -181,6 +213,50 @@ class Element : public std::enable_shared_from_this<Element> {
 
     // This is used for relayout
     BoxConstraints prev_constraints;
+
+    // Whether the element or some of its descendants inside of the same
+    // relayout boundary was changed since last layout. When element does not
+    // need layout and receives same constraints, its layout is skipped and
+    // the size from the previous layout is reused.
+    bool needs_layout = true;
+
+    // Size returned from the last layout
+    Size prev_size;
+
+    IntrinsicSizeCache intrinsic_height_cache;
+    IntrinsicSizeCache intrinsic_width_cache;
+
+    // Recording of the last painting of the element and its children in the
+    // coordinates of the layer of its repaint boundary. When the element is
+    // not changed, it is replayed instead of calling `paint`.
+    sk_sp<SkPicture> display_list;
+
+    // Offset of the element from its repaint boundary when it was recorded
+    Position display_list_offset;
+
+    // Size from the layout of the element when it was recorded
+    Size display_list_size;
+
+    // Whether some repaint boundary or batched icon was painted inside of this
+    // element during the last paint. Such elements paint directly into the
+    // layers, because nested boundaries have separate layers, and icons are
+    // drawn in batches.
+    bool paints_directly = false;
+
+    RepaintStats repaint_stats;
+
+    // Index for hit testing of the elements inside of the repaint boundary
+    std::shared_ptr<BoundaryHitTestIndex> hit_test_index;
+
+    // Depth of the element in the tree, it is updated during layout
+    int depth = 0;
+
+    // Numbers of the last relayout and repaint passes of the document in which
+    // this element was laid out or painted. They are used to skip elements
+    // that were already processed as part of some of their ancestors.
+    // Elements whose layout was skipped keep their previous layout pass.
+    int layout_pass = 0;
+    int paint_pass = 0;
 };
 
 class SingleChildElement : public Element {
@@ -191,10 +267,10 @@ class SingleChildElement : public Element {
         bool size_depends_on_parent);
 
     float get_intrinsic_height(float width) override {
-        return child == nullptr ? 0 : child->get_intrinsic_height(width);
+        return child == nullptr ? 0 : child->query_intrinsic_height(width);
     }
     float get_intrinsic_width(float height) override {
-        return child == nullptr ? 0 : child->get_intrinsic_width(height);
+        return child == nullptr ? 0 : child->query_intrinsic_width(height);
     }
     Size layout(BoxConstraints constraints) override;
     void paint(bool is_changed) override;
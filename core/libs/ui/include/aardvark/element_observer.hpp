@@ -2,6 +2,7 @@
 
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <nod/nod.hpp>
 #include <unordered_map>
 #include <vector>
@@ -80,8 +81,10 @@ class ElementObserver
         if (it != observed_elements.end()) observed_elements.remove(it);
     }
 
-    // Marks that value of the observed property of the element might change
+    // Marks that value of the observed property of the element might change.
+    // Can be called from the layout threads.
     void trigger_element(std::shared_ptr<Element> element) {
+        auto lock = std::lock_guard<std::mutex>(triggered_mutex);
         auto it = observed_elements.find(element);
         if (it != observed_elements.end()) triggered_elements.insert(element);
     }
@@ -104,6 +107,7 @@ class ElementObserver
     std::unordered_map<std::shared_ptr<Element>, ElementObserverEntry>
         observed_elements;
     std::unordered_set<std::shared_ptr<Element>> triggered_elements;
+    std::mutex triggered_mutex;
 
     void disconnect(ElementObserverConnection<T>* connection) {
         auto element = connection->element.lock();
@@ -100,8 +100,6 @@ class BorderElement : public SingleChildElement {
 
   private:
     SkCanvas* canvas;
-    SkPath clip_path;
-    SkMatrix clip_matrix;
     SkMatrix matrix;
     int rotation;
     void paint_borders(SkCanvas* canvas);
@@ -111,12 +109,6 @@ class BorderElement : public SingleChildElement {
         BorderSide& next_side,
         Radius& left_radius,
         Radius& right_radius);
-    void clip_side(
-        BorderSide& prev_side,
-        BorderSide& side,
-        BorderSide& next_side,
-        Radius& left_radius,
-        Radius& right_radius);
     void paint_triangle(
         Radius& radius,
         BorderSide& prev_side,
@@ -3,12 +3,14 @@
 #include <functional>
 
 #include "../base_types.hpp"
+#include "../clip.hpp"
 #include "../element.hpp"
-#include "SkPath.h"
 
 namespace aardvark {
 
-using Clipper = std::function<SkPath(Size)>;
+// Paths returned by clippers are converted to rects or rounded rects when
+// possible
+using Clipper = std::function<Clip(Size)>;
 
 class ClipElement : public SingleChildElement {
   public:
@@ -30,7 +32,7 @@ class ClipElement : public SingleChildElement {
 
     Clipper clipper = &ClipElement::default_clip;
 
-    static SkPath default_clip(Size size);
+    static Clip default_clip(Size size);
 };
 
 }  // namespace aardvark
@@ -5,6 +5,7 @@
 
 #include "../base_types.hpp"
 #include "../element.hpp"
+#include "../image_cache.hpp"
 #include "../utils/data_source.hpp"
 
 namespace aardvark {
@@ -42,19 +43,42 @@ class ImageElement : public Element {
     void paint(bool is_changed) override;
 
     std::shared_ptr<DataSource> src = nullptr;
+
+    // Previous image is shown until the image of the new source is decoded
     void set_src(std::shared_ptr<DataSource> src) {
         this->src = std::move(src);
-        data.clear();
-        image = nullptr;
+        is_image_requested = false;
+        change();
     }
 
     ELEMENT_PROP_DEFAULT(ImageFit, fit, ImageFit::none);
     ELEMENT_PROP(Size, custom_size);
 
+    // When enabled, small images are drawn from the icon atlas of the
+    // document, in batches with other icons of the same layer
+    ELEMENT_PROP_DEFAULT(bool, use_icon_atlas, false);
+
+    // Image is decoded at the size at which it is painted. Returns `nullptr`
+    // until the image is decoded.
+    sk_sp<SkImage> get_image() { return image.image; }
+
   private:
-    void init_image();
-    std::string data = "";
-    sk_sp<SkImage> image = nullptr;
+    // Props that define the size at which the image is painted
+    struct SizeProps {
+        Size size;
+        ImageFit fit;
+        Size custom_size;
+        float pixel_ratio;
+
+        SkISize get_decode_size(SkISize original_size) const;
+    };
+
+    SizeProps get_size_props();
+    void request_image();
+    bool is_image_requested = false;
+    // Props from which the size of the requested image was calculated
+    SizeProps requested_props;
+    DecodedImage image;
 };
 
 using ColorMap = std::unordered_map<std::string, Color>;
@@ -81,16 +105,39 @@ class SvgImageElement : public Element {
     void set_src(std::shared_ptr<DataSource> src) {
         this->src = std::move(src);
         svg = nullptr;
+        raster = nullptr;
+        raster_variant.clear();
     }
 
     ELEMENT_PROP_DEFAULT(ImageFit, fit, ImageFit::none);
     ELEMENT_PROP(Size, custom_size);
     ELEMENT_PROP_DEFAULT(ColorMap, color_map, {});
 
+    // When enabled, image is rasterized at the painted size and the raster is
+    // cached in the image cache, where it is shared between the elements with
+    // the same source, size and color map. Raster is not sharp when the
+    // element is painted with scaling transform.
+    ELEMENT_PROP_DEFAULT(bool, raster_cache, false);
+
+    // When enabled, image is rasterized as with `raster_cache`, and small
+    // rasters are drawn from the icon atlas of the document, in batches with
+    // other icons of the same layer
+    ELEMENT_PROP_DEFAULT(bool, use_icon_atlas, false);
+
   private:
     void init_svg();
+    void update_color_map();
+    void render_svg(SkCanvas* canvas, Size img_size);
+    sk_sp<SkImage> get_raster(Size img_size, Size fit_size);
     std::shared_ptr<SVGNative::SkiaSVGRenderer> renderer;
     std::unique_ptr<SVGNative::SVGDocument> svg;
+    // Color map is converted only when it is changed
+    ColorMap converted_color_map;
+    SVGNative::ColorMap svg_color_map;
+    std::string color_map_key;
+    // Raster of the last painted variant
+    std::string raster_variant;
+    sk_sp<SkImage> raster = nullptr;
 };
 
 }  // namespace aardvark
@@ -11,13 +11,16 @@ class LayerElement : public SingleChildElement {
         : SingleChildElement(
               /* child */ nullptr,
               /* is_repaint_boundary */ true,
-              /* size_depends_on_parent */ false){};
+              /* size_depends_on_parent */ false) {
+        is_repaint_boundary_fixed = true;
+    };
 
     LayerElement(std::shared_ptr<Element> child, Transform transform)
         : SingleChildElement(
               std::move(child),
               /* is_repaint_boundary */ true,
               /* size_depends_on_parent */ false) {
+        is_repaint_boundary_fixed = true;
         set_transform(transform);
     };
 
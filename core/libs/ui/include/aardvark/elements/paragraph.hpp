@@ -5,6 +5,7 @@
 #include "../inline_layout/span.hpp"
 #include "../inline_layout/utils.hpp"
 #include "../inline_layout/decoration_span.hpp"
+#include "../inline_layout/line_text.hpp"
 
 namespace aardvark {
 
@@ -20,6 +21,28 @@ struct Selection {
 struct ParagraphLine {
     inline_layout::LineMetrics metrics;
     std::vector<std::shared_ptr<inline_layout::Span>> spans;
+    // Index of the child of the root span from which the line starts
+    int start_child = 0;
+    // Remaining part of that child that starts the line, and its text length
+    std::shared_ptr<inline_layout::Span> start_span;
+    int start_length = 0;
+    float top = 0;
+    // Text spans are painted from the blobs, other spans are rendered into
+    // elements
+    std::vector<inline_layout::LineTextBlob> blobs;
+    std::vector<std::shared_ptr<Element>> elements;
+};
+
+// Work of the last inline layout of the paragraph
+struct ParagraphLayoutCounters {
+    int lines_laid_out = 0;
+    // Lines that were kept from the previous layout
+    int lines_reused = 0;
+    int elements_rendered = 0;
+    // Elements of the previous layout that were kept or updated for new spans
+    int elements_reused = 0;
+    // Text spans that were added to the blobs of the lines
+    int text_spans_batched = 0;
 };
 
 class ParagraphElement : public Element {
@@ -53,15 +76,40 @@ class ParagraphElement : public Element {
 
     std::vector<int> get_offset_at_position(Position pos);
 
+    ParagraphLayoutCounters last_layout_counters;
+
   private:
+    using ChildRevision = std::pair<inline_layout::Span*, int>;
+
     void next_line();
     float layout_inline(float max_width);
-    void layout_span(std::shared_ptr<inline_layout::Span> span_sp);
+    std::shared_ptr<inline_layout::Span> layout_span(
+        std::shared_ptr<inline_layout::Span> span_sp);
+    std::vector<ChildRevision> get_child_revisions();
+    std::shared_ptr<inline_layout::Span> make_line_start(
+        const ParagraphLine& line);
+    void set_line_start(ParagraphLine& line, inline_layout::Span* span);
+    void render_line(
+        ParagraphLine& line,
+        std::vector<std::shared_ptr<Element>>* recycled);
+    void render_span(
+        const std::shared_ptr<inline_layout::Span>& span,
+        const inline_layout::LineMetrics& container_metrics,
+        Position offset,
+        ParagraphLine& line,
+        inline_layout::LineTextBuilder& builder,
+        std::vector<std::shared_ptr<Element>>* recycled);
     std::vector<ParagraphLine> lines;
     ParagraphLine* current_line;
     std::vector<std::shared_ptr<Element>> elements;
     float total_width;
     float remaining_width;
+    // State of the previous layout, that is used to find reusable lines
+    std::shared_ptr<inline_layout::Span> laid_out_root;
+    // Own revision of the root, its decoration is applied to all lines
+    int laid_out_root_revision = 0;
+    std::vector<ChildRevision> laid_out_children;
+    float laid_out_width = 0;
 };
 
 }  // namespace aardvark::elements
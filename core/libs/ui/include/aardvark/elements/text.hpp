@@ -5,8 +5,9 @@
 #include <memory>
 
 #include "../element.hpp"
-#include "../inline_layout/utils.hpp"
+#include "../inline_layout/font_cache.hpp"
 #include "../inline_layout/line_metrics.hpp"
+#include "../inline_layout/utils.hpp"
 #include "SkPaint.h"
 #include "SkFont.h"
 
@@ -28,8 +29,11 @@ using TextDecorationList = std::vector<TextDecoration>;
 
 struct TextStyle {
     Color color = Color::from_sk_color(SK_ColorBLACK);
+    // Comma-separated list of families, the first available one is used
     std::string font_family;
     int font_size = 16;
+    int font_weight = 400;
+    bool italic = false;
     float line_height = 1;
     TextDecorationList decorations;
 
@@ -40,17 +44,20 @@ struct TextStyle {
         return paint;
     }
 
-    SkFont to_sk_font() {
-        SkFont font;
-        font.setSize(font_size);
-        auto typeface = SkTypeface::MakeFromName("PT Sans", 
-          SkFontStyle(400,5,  SkFontStyle::Slant::kUpright_Slant));
-        font.setTypeface(typeface);
-        return font;
+    // Font and metrics are shared by all texts with the same font properties
+    const inline_layout::CachedFont& get_cached_font() {
+        auto slant = italic ? SkFontStyle::kItalic_Slant
+                            : SkFontStyle::kUpright_Slant;
+        return inline_layout::FontCache::get_font(
+            font_family,
+            SkFontStyle(font_weight, SkFontStyle::kNormal_Width, slant),
+            font_size);
     }
 
+    SkFont to_sk_font() { return get_cached_font().font; }
+
     inline_layout::LineMetrics get_metrics() {
-        return inline_layout::LineMetrics::from_sk_font(to_sk_font());
+        return get_cached_font().metrics;
     }
 };
 
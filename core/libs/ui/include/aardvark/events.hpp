@@ -2,6 +2,7 @@
 
 #include <variant>
 #include <functional>
+#include <vector>
 
 namespace aardvark {
 
@@ -49,6 +50,13 @@ enum class PointerAction {
     scroll
 };
 
+// Position of the pointer at some moment
+struct PointerEventSample {
+    int timestamp;
+    float left;
+    float top;
+};
+
 struct PointerEvent {
     int timestamp;
     PointerTool tool;
@@ -57,6 +65,10 @@ struct PointerEvent {
     float left;
     float top;
     int button;
+    // When multiple move events of the pointer are received during one frame,
+    // they are merged into a single event. This contains samples of all merged
+    // events including the last one, from oldest to newest.
+    std::vector<PointerEventSample> coalesced = {};
 };
 
 // Keyboard
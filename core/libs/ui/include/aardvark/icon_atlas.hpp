@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "SkCanvas.h"
+#include "SkImage.h"
+#include "SkSurface.h"
+
+namespace aardvark {
+
+struct IconAtlasStats {
+    int64_t icons_added = 0;
+    // Icons that were removed from the atlas when it was full
+    int64_t evictions = 0;
+    int64_t repacks = 0;
+};
+
+// Texture of the atlas that icons are packed into. Icons are placed on the
+// shelves, rows of the height of the tallest icon in the row.
+class IconAtlasPage {
+  public:
+    IconAtlasPage(int size);
+
+    // Returns place for the icon of the specified size, or `std::nullopt`
+    // when the page is full
+    std::optional<SkIRect> allocate(SkISize size);
+
+    // Canvas to draw icons into the page
+    SkCanvas* get_canvas();
+
+    // Snapshot of the page, it is taken again after the page is changed
+    sk_sp<SkImage> get_image();
+
+  private:
+    struct Shelf {
+        int top;
+        int height;
+        int used_width;
+    };
+
+    int size;
+    sk_sp<SkSurface> surface;
+    sk_sp<SkImage> image = nullptr;
+    std::vector<Shelf> shelves;
+};
+
+// Place of the icon in the atlas
+struct AtlasIcon {
+    std::shared_ptr<IconAtlasPage> page;
+    SkRect rect;
+};
+
+// Packs small images into shared textures, so many icons can be drawn with a
+// single `drawAtlas` call. Icons are identified by the images they are copied
+// from. When the atlas is full, icons that are not used in the current frame
+// are evicted and remaining icons are packed again into new pages.
+class IconAtlas {
+  public:
+    static constexpr int PAGE_SIZE = 1024;
+    static constexpr int MAX_PAGES = 4;
+    // Bigger images are not placed in the atlas
+    static constexpr int MAX_ICON_SIZE = 128;
+
+    IconAtlas(int page_size = PAGE_SIZE, int max_pages = MAX_PAGES)
+        : page_size(page_size), max_pages(max_pages){};
+
+    // Returns place of the image in the atlas, adding it when it is not there
+    // yet. Returns `std::nullopt` when the image is too big, or there is no
+    // space for it even after repacking.
+    std::optional<AtlasIcon> get_icon(const sk_sp<SkImage>& image, int frame);
+
+    int get_pages_count() { return pages.size(); }
+
+    IconAtlasStats stats;
+
+  private:
+    struct Entry {
+        std::shared_ptr<IconAtlasPage> page;
+        SkIRect rect;
+        // Frame in which icon was used last time
+        int last_used;
+    };
+
+    std::optional<Entry> allocate(SkISize size);
+    void repack(int frame);
+
+    int page_size;
+    int max_pages;
+    // Atlas is repacked at most once per frame
+    int last_repack_frame = -1;
+    std::vector<std::shared_ptr<IconAtlasPage>> pages;
+    // Icons by unique ids of their images
+    std::unordered_map<uint32_t, Entry> entries;
+};
+
+}  // namespace aardvark
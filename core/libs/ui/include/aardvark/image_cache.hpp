@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "SkImage.h"
+#include "SkSize.h"
+#include "utils/data_source.hpp"
+#include "utils/event_loop.hpp"
+
+namespace aardvark {
+
+struct ImageCacheStats {
+    int64_t hits = 0;
+    int64_t misses = 0;
+    // Images that were decoded, requests of the image that is being decoded
+    // wait for the same decoding
+    int64_t decodes = 0;
+    // Images that were rendered by the callers of `get_rendered_image`
+    int64_t renders = 0;
+    int64_t evictions = 0;
+    // Total size of the pixels of the cached images
+    int64_t bytes = 0;
+};
+
+// Decoded image can be smaller than the original image
+struct DecodedImage {
+    sk_sp<SkImage> image = nullptr;
+    SkISize original_size = SkISize::MakeEmpty();
+};
+
+// Receives decoded image, or empty image when the data can not be decoded
+using ImageCallback = std::function<void(DecodedImage)>;
+
+// Returns size in pixels at which the image of the original size is needed.
+// It can be called from the background threads.
+using ImageSizer = std::function<SkISize(SkISize original_size)>;
+
+// Renders image on the calling thread, returns `nullptr` on failure
+using ImageRenderer = std::function<sk_sp<SkImage>()>;
+
+// Process-wide cache of decoded images, keyed by the identity of their
+// sources. Images are decoded on the background threads. When total size of
+// the decoded images exceeds the budget, least recently used images are
+// evicted.
+//
+// Images are decoded at the size requested by the sizer, using scaling of the
+// codec when it is supported. Requests of smaller sizes are served by the
+// image of the same source that is already decoded, and the image is decoded
+// again only when a bigger size is requested.
+class ImageCache {
+  public:
+    static constexpr int64_t DEFAULT_BUDGET = 256 * 1024 * 1024;
+
+    // Returns cached image. When there is no image or it is smaller than
+    // needed, starts decoding, and callback is posted to the event loop when
+    // decoding is finished. Without event loop, image is decoded on the
+    // calling thread and returned. Without sizer, image is decoded at the
+    // original size.
+    static DecodedImage get_image(
+        const std::shared_ptr<DataSource>& src,
+        const ImageSizer& sizer,
+        EventLoop* event_loop,
+        ImageCallback callback);
+
+    // Returns image that is rendered from the source, e.g. rasterized vector
+    // image. Variant identifies all other inputs of the rendering, images of
+    // different variants of the same source are cached separately. When there
+    // is no cached image, it is rendered on the calling thread.
+    static sk_sp<SkImage> get_rendered_image(
+        const std::shared_ptr<DataSource>& src,
+        const std::string& variant,
+        const ImageRenderer& render);
+
+    // Evicts images if the cache is over the new budget
+    static void set_budget(int64_t bytes);
+
+    static ImageCacheStats get_stats();
+
+    // Removes all cached images and resets stats. Decodings that are in
+    // progress are not cancelled.
+    static void clear();
+};
+
+}  // namespace aardvark
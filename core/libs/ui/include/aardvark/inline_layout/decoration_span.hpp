@@ -42,7 +42,7 @@ class DecorationSpan : public MultipleChildrenSpan {
     std::shared_ptr<Span> slice(int start, int end) override;
     int get_offset_at_position(float position) override;
 
-    Decoration decoration;
+    NODE_PROP(Decoration, decoration);
 };
 
 }  // namespace aardvark::inline_layout
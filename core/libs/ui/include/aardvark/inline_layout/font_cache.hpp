@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "SkFont.h"
+#include "SkFontStyle.h"
+#include "SkTypeface.h"
+#include "line_metrics.hpp"
+
+namespace aardvark::inline_layout {
+
+// Font with its metrics, they are the same for all texts with the same style
+struct CachedFont {
+    SkFont font;
+    LineMetrics metrics;
+};
+
+struct FontCacheStats {
+    int64_t hits = 0;
+    int64_t misses = 0;
+    // Typefaces that were requested from the font manager
+    int64_t typefaces_loaded = 0;
+};
+
+// Process-wide cache of typefaces and fonts, keyed by family, weight, slant
+// and size. It can be used from the layout threads.
+class FontCache {
+  public:
+    // Family that is used when none of the requested families is available
+    static constexpr const char* DEFAULT_FAMILY = "PT Sans";
+
+    // Family is a comma-separated list of families in the order of preference.
+    // Returned reference stays valid until the cache is cleared.
+    static const CachedFont& get_font(
+        const std::string& family, SkFontStyle style, float size);
+
+    static sk_sp<SkTypeface> get_typeface(
+        const std::string& family, SkFontStyle style);
+
+    static FontCacheStats get_stats();
+
+    // Removes all cached fonts. It should not be called while fonts returned
+    // by the cache are used, for example, during layout.
+    static void clear();
+};
+
+}  // namespace aardvark::inline_layout
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <unicode/brkiter.h>
+#include <unicode/locid.h>
+#include <unicode/unistr.h>
+
+#include <vector>
+
+namespace aardvark::inline_layout {
+
+// Finds line break opportunities using ICU line break iterators. Creating an
+// iterator is expensive, so the first iterator of each locale is kept as a
+// prototype, and iterators are cloned from it and reused. It can be used from
+// the layout threads.
+class LineBreaks {
+  public:
+    // Returns positions in the text where line can be broken, including the
+    // start and the end of the text
+    static std::vector<int> find(
+        const UnicodeString& text, const Locale& locale = Locale::getUS());
+
+    // Number of iterators that were created, including clones
+    static int get_created_iterators();
+};
+
+}  // namespace aardvark::inline_layout
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <SkColor.h>
+#include <SkTextBlob.h>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "text_span.hpp"
+
+namespace aardvark::inline_layout {
+
+// Glyphs of the text of a line that have the same color, so they are painted
+// with a single draw call
+struct LineTextBlob {
+    SkColor color;
+    sk_sp<SkTextBlob> blob;
+};
+
+// Builds blobs of the line from the glyphs that were shaped during the layout
+// of the text spans, without converting the text again
+class LineTextBuilder {
+  public:
+    // Adds glyphs of the span, position is the top left corner of the span
+    // relative to the line
+    void add_span(TextSpan* span, float left, float top);
+
+    // Returns blobs of all added spans, one for each color
+    std::vector<LineTextBlob> build();
+
+  private:
+    std::vector<std::pair<SkColor, std::unique_ptr<SkTextBlobBuilder>>>
+        builders;
+};
+
+}  // namespace aardvark::inline_layout
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <SkFont.h>
+#include <unicode/unistr.h>
+
+#include <vector>
+
+namespace aardvark::inline_layout {
+
+// Glyphs and advances of the text, shaped once and shared by the text span and
+// all spans that are split or sliced from it. Positions are UTF-16 code units,
+// widths of ranges are differences of the prefix sums of the advances.
+class ShapedText {
+  public:
+    ShapedText(const UnicodeString& text, const SkFont& font);
+
+    SkFont font;
+
+    // Length of the text in code units
+    int length;
+
+    std::vector<SkGlyphID> glyphs;
+
+    // Offsets of the glyphs from the start of the text, has one more element
+    // than there are glyphs, so the last element is the width of the text
+    std::vector<float> offsets;
+
+    // Index of the glyph of each code unit, and one more element for the end
+    // of the text
+    std::vector<int> unit_glyphs;
+
+    // Index of the first code unit of each glyph, and the length of the text
+    std::vector<int> glyph_units;
+
+    int get_glyph_count() const { return static_cast<int>(glyphs.size()); }
+
+    // Width of the text between code units
+    float get_width(int start, int end) const;
+
+    // Returns position of the end of the longest text after the start that
+    // is not wider than the max width, and is not after the end position.
+    // Text is broken only between glyphs.
+    int fit(int start, int end, float max_width, float* width) const;
+
+    // Returns position of the glyph boundary closest to the specified
+    // distance from the start
+    int find_position(int start, int end, float distance) const;
+
+    // Returns position of the start of the glyph before the position
+    int prev_position(int pos) const;
+
+    // Returns position of the end of the glyph at the position
+    int next_position(int pos) const;
+};
+
+}  // namespace aardvark::inline_layout
@@ -80,6 +80,11 @@ class Span : public std::enable_shared_from_this<Span>,
     // Returns elements that represent this span in the document
     virtual std::shared_ptr<Element> render() = 0;
 
+    // Updates element that was rendered by another span of the same kind, so
+    // it represents this span and can be reused instead of rendering a new
+    // one. Returns `false` when the element can not be updated.
+    virtual bool update_element(Element* elem) { return false; }
+
     // Calculates position of the span in the line, default is baseline
     virtual float vert_align(LineMetrics line, LineMetrics span) {
         return vert_align::baseline(line, span);
@@ -1,12 +1,12 @@
 #pragma once
 
-#include <unicode/brkiter.h>
-
 #include <memory>
 #include <optional>
 
 #include "../element.hpp"
 #include "../elements/text.hpp"
+#include "line_breaks.hpp"
+#include "shaped_text.hpp"
 #include "span.hpp"
 #include "utils.hpp"
 
@@ -39,10 +39,9 @@ class TextSpan : public Span {
 
     void init();
 
-    ~TextSpan() override;
-
     InlineLayoutResult layout(InlineConstraints constraints) override;
     std::shared_ptr<Element> render() override;
+    bool update_element(Element* elem) override;
     UnicodeString get_text() override;
     int get_text_length() override;
     std::shared_ptr<Span> slice(int start, int end) override;
@@ -55,6 +54,8 @@ class TextSpan : public Span {
     // TODO decide utf8/16
     void set_text(std::string& new_text) {
         text = UnicodeString(new_text.c_str());
+        shaped = nullptr;
+        breaks = nullptr;
         change();
     }
 
@@ -64,15 +65,33 @@ class TextSpan : public Span {
         return utf8;
     }
 
+    // Returns text shaped with the font of the style. Spans that are derived
+    // from this span share its shaped text.
+    const ShapedText& get_shaped_text();
+
+    // Offset of the text of this span in its shaped text
+    int get_shaped_offset() { return shaped_offset; }
+
+    // Returns positions of line break opportunities in the text. Breaks are
+    // found once and shared with the spans derived from this span, positions
+    // are offset by `get_line_breaks_offset()`.
+    const std::vector<int>& get_line_breaks();
+
+    // Offset of the text of this span in its line breaks
+    int get_line_breaks_offset() { return breaks_offset; }
+
   private:
-    SkFont font;
-    BreakIterator* linebreaker;
-    std::optional<std::vector<float>> glyph_widths = std::nullopt;
+    std::shared_ptr<ShapedText> shaped;
+    int shaped_offset = 0;
+    std::shared_ptr<std::vector<int>> breaks;
+    int breaks_offset = 0;
+    float get_width(int start, int end);
     InlineLayoutResult split(int pos, float measured_width);
     InlineLayoutResult fit(float measured_width);
     InlineLayoutResult wrap();
     InlineLayoutResult break_segment(
-        const UnicodeString& text,
+        int start,
+        int end,
         const InlineConstraints& constraints,
         bool is_last_segment);
 };
@@ -16,18 +16,6 @@ float measure_text_width(
     const SkFont& font,
     std::optional<int> num_chars = std::nullopt);
 
-std::vector<float> get_glyph_widths(
-    const UnicodeString& text, const SkFont& font);
-
-int find_break_position(
-    float max_width, std::vector<float> glyph_widths, float* measured_width);
-
-int break_text(
-    const UnicodeString& text,
-    const SkFont& font,
-    float available_width,
-    float* width = nullptr);
-
 // Converts ICU UnicodeString to C++ std string (with UTF-16 encoding)
 std::string icu_to_std_string(const UnicodeString& text);
 
@@ -36,13 +24,16 @@ LineMetrics calc_combined_metrics(
     const std::vector<std::shared_ptr<Span>>& spans,
     const LineMetrics& default_metrics);
 
-// Renders list of spans into the provided container
-void render_spans(
+// Renders list of spans into the provided container. Elements from the
+// `recycled` list, that were rendered by this function earlier, are updated and
+// reused when possible. Returns number of the reused elements.
+int render_spans(
     const std::vector<std::shared_ptr<Span>>& spans,
     const LineMetrics& metrics,
     const Position& offset,
     std::vector<std::shared_ptr<Element>>* container,
-    Element* parent);
+    Element* parent,
+    std::vector<std::shared_ptr<Element>>* recycled = nullptr);
 
 SkPaint make_default_paint();
 SkFont make_default_font();
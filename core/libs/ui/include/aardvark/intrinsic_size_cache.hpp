@@ -0,0 +1,42 @@
+#pragma once
+
+#include <array>
+#include <optional>
+#include <utility>
+
+namespace aardvark {
+
+// Cache of the intrinsic size of an element along one axis, keyed by the size
+// along the cross axis. It keeps few most recent entries, because element is
+// usually queried with the same small set of sizes.
+class IntrinsicSizeCache {
+  public:
+    std::optional<float> get(float cross_size) {
+        for (auto i = 0; i < count; i++) {
+            if (entries[i].first == cross_size) return entries[i].second;
+        }
+        return std::nullopt;
+    };
+
+    void set(float cross_size, float size) {
+        entries[next] = std::make_pair(cross_size, size);
+        next = (next + 1) % CAPACITY;
+        if (count < CAPACITY) count++;
+    };
+
+    bool empty() { return count == 0; };
+
+    void clear() {
+        count = 0;
+        next = 0;
+    };
+
+  private:
+    static constexpr int CAPACITY = 4;
+    std::array<std::pair<float, float>, CAPACITY> entries;
+    int count = 0;
+    // Index of the entry that will be replaced next
+    int next = 0;
+};
+
+}  // namespace aardvark
@@ -20,6 +20,8 @@ class Layer {
   public:
     Layer(sk_sp<SkSurface> surface);
 
+    // Size of the used area of the layer. It can be smaller than the size of
+    // the surface when the surface is reused from the pool.
     Size size;
     sk_sp<SkSurface> surface;
     SkCanvas* canvas;
@@ -41,8 +43,17 @@ class Layer {
 
     static std::shared_ptr<Layer> make_screen_layer(
         sk_sp<GrDirectContext> gr_context);
+    // Creates offscreen layer. When `gr_context` is null, layer is backed by
+    // the raster surface.
     static std::shared_ptr<Layer> make_offscreen_layer(
         sk_sp<GrDirectContext> gr_context, Size size);
+    // Creates layer that is backed by the CPU raster surface and does not
+    // require GPU context.
+    static std::shared_ptr<Layer> make_raster_layer(Size size);
+
+    // Creates surface for the offscreen layer
+    static sk_sp<SkSurface> make_offscreen_surface(
+        sk_sp<GrDirectContext> gr_context, Size size);
 
   private:
     bool is_changed = true;
@@ -5,7 +5,7 @@
 #include <variant>
 #include <vector>
 #include "SkMatrix.h"
-#include "SkPath.h"
+#include "clip.hpp"
 #include "element.hpp"
 #include "layer.hpp"
 
@@ -16,6 +16,17 @@ class Element;
 
 using LayerTreeNode = std::variant<LayerTree*, std::shared_ptr<Layer>>;
 
+// Compose properties of the layer tree that are driven by native animations.
+// They are applied on top of the `transform` and `opacity` of the tree.
+struct AnimatedLayerValues {
+    float opacity = 1;
+    float translate_left = 0;
+    float translate_top = 0;
+    // Scale and rotation in degrees around the center of the element
+    float scale = 1;
+    float rotation = 0;
+};
+
 class LayerTree {
   public:
     LayerTree(Element* element);
@@ -29,12 +40,33 @@ class LayerTree {
     // Child layers and trees
     std::vector<LayerTreeNode> children;
 
-    std::optional<SkPath> clip;
-
     SkMatrix transform;
 
     float opacity = 1;
 
+    AnimatedLayerValues animated;
+
+    // Whether contents or compose properties of the tree were changed since
+    // the last composition. When the tree is changed, its area is damaged.
+    bool is_changed = true;
+
+    // Transform and opacity that are used for composition, including the
+    // animated values
+    SkMatrix get_compose_transform();
+
+    float get_compose_opacity() { return opacity * animated.opacity; }
+
+    // Clip of the tree relative to its element, it is applied to the contents
+    // of the tree without the transform of the tree.
+    const std::optional<Clip>& get_clip() { return clip; };
+
+    void set_clip(std::optional<Clip> new_clip);
+
+    // Returns clip mapped by the inverse of the compose transform, so it can be
+    // applied after the transform. Result is cached until the clip or the
+    // transform is changed.
+    const std::optional<Clip>& get_transformed_clip(const SkMatrix& transform);
+
     // Adds new item to the tree
     void add(LayerTreeNode item);
 
@@ -43,6 +75,12 @@ class LayerTree {
 
     // Add this tree to new parent, and remove from old one
     // void set_parent(LayerTree* new_parent);
+
+  private:
+    std::optional<Clip> clip;
+    std::optional<Clip> transformed_clip;
+    SkMatrix transformed_clip_matrix;
+    bool is_transformed_clip_valid = false;
 };
 
 }  // namespace aardvark
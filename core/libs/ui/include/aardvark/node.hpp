@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <functional>
 #include <memory>
 
@@ -41,9 +43,22 @@ class Node {
     virtual std::shared_ptr<T> get_child_at(int index) { return nullptr; }
 
     void change() {
+        own_revision = next_revision();
+        revision = own_revision;
         if (change_fn && owner != nullptr) change_fn(owner, node_from_this());
     }
 
+    // Returns the latest revision among the node and its descendants. It is
+    // different after any change inside of the subtree, including adding or
+    // removing nodes.
+    int get_tree_revision() {
+        auto result = revision;
+        visit_children([&result](std::shared_ptr<T>& child) {
+            result = std::max(result, child->get_tree_revision());
+        });
+        return result;
+    }
+
     bool is_parent_of(T* elem) {
         auto current = elem->parent;
         while (current) {
@@ -64,9 +79,29 @@ class Node {
     OwnerT* owner = nullptr;
     T* parent = nullptr;
 
+    // Revision is updated on every change of the node. Revisions are taken
+    // from the counter shared by all nodes, so after adding or removing a
+    // child, the revision of the parent is greater than any in its subtree.
+    int revision = 0;
+    // Revision of the last change of the node itself, it is not updated when
+    // children are added or removed.
+    int own_revision = 0;
+
+  protected:
+    // Notifies about adding or removing children of the node
+    void change_children() {
+        revision = next_revision();
+        if (change_fn && owner != nullptr) change_fn(owner, node_from_this());
+    }
+
   private:
     NodeChangeFunc<T, OwnerT> change_fn;
     T* node_from_this() { return dynamic_cast<T*>(this); }
+
+    static int next_revision() {
+        static std::atomic<int> last_revision = 0;
+        return ++last_revision;
+    }
 };
 
 template <typename T, typename OwnerT>
@@ -82,7 +117,7 @@ class SingleChildNode : public virtual Node<T, OwnerT> {
         if (this->child == child) {
             // Change is called before removing, so the owner can check if this
             // changed element is parent of another one
-            this->change();
+            this->change_children();
             this->child->parent = nullptr;
             this->child->set_owner(nullptr);
             this->child = nullptr;
@@ -94,7 +129,7 @@ class SingleChildNode : public virtual Node<T, OwnerT> {
         this->child = child;
         this->child->set_owner(this->owner);
         this->child->parent = dynamic_cast<T*>(this);
-        this->change();
+        this->change_children();
     }
 
     int find_child(std::shared_ptr<T> child) override {
@@ -128,13 +163,13 @@ class MultipleChildrenNode : public virtual Node<T, OwnerT> {
         child->parent = dynamic_cast<T*>(this);
         child->set_owner(this->owner);
         children.push_back(child);
-        this->change();
+        this->change_children();
     }
 
     void remove_child(std::shared_ptr<T> child) override {
         auto it = std::find(children.begin(), children.end(), child);
         if (it != children.end()) {
-            this->change();
+            this->change_children();
             child->parent = nullptr;
             child->set_owner(nullptr);
             children.erase(it);
@@ -149,7 +184,7 @@ class MultipleChildrenNode : public virtual Node<T, OwnerT> {
         child->parent = dynamic_cast<T*>(this);
         child->set_owner(this->owner);
         children.insert(it, child);
-        this->change();
+        this->change_children();
     }
 
     int find_child(std::shared_ptr<T> child) override {
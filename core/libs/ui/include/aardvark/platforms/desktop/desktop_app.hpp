@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <unordered_map>
 #include <vector>
 #include <functional>
@@ -20,13 +22,19 @@ struct DesktopWindowOptions;
 
 class DesktopApp {
   public:
-    DesktopApp(std::shared_ptr<EventLoop> event_loop)
-        : event_loop(std::move(event_loop)){};
+    // Called before rendering a frame with the time of the frame in
+    // milliseconds since the start of the application.
+    using FrameCallback = std::function<void(double frame_time)>;
 
-    // Runs application loop - polls events, calls handlers and repaints
-    void run(std::function<void(void)> update_callback = nullptr);
+    DesktopApp(std::shared_ptr<EventLoop> event_loop);
 
-    void render(std::function<void(void)> update_callback);
+    // Runs application loop - waits for events, calls handlers and renders
+    // frames when they are requested
+    void run(FrameCallback update_callback = nullptr);
+
+    // Requests rendering of a new frame. Multiple requests are coalesced into
+    // a single frame. This method can be called from any thread.
+    void request_frame();
 
     // Stops application loop
     void stop();
@@ -50,13 +58,26 @@ class DesktopApp {
 
     void handle_event(DesktopWindow* window, Event event);
 
+    // Recomposes contents of the window, for example after it was uncovered
+    void refresh_window(DesktopWindow* window);
+
     // Dispatches event to the corresponding App instance
     static void dispatch_event(GLFWwindow* window, Event event);
 
   private:
+    using Clock = std::chrono::steady_clock;
+
     std::shared_ptr<EventLoop> event_loop;
-    bool should_stop;
+    std::atomic<bool> should_stop{false};
+    std::atomic<bool> frame_requested{false};
+    FrameCallback update_callback;
+    Clock::time_point start_time;
+    Clock::time_point next_frame_time;
     std::unordered_map<DesktopWindow*, std::shared_ptr<Document>> documents;
+
+    void loop();
+    void wait_events();
+    void render();
 };
 
 }  // namespace aardvark
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vector>
+
+#include "SkPoint.h"
+#include "SkRect.h"
+
+namespace aardvark {
+
+// Bounding volume hierarchy of rects that allows to quickly find all rects
+// that contain a point.
+class HitTestIndex {
+  public:
+    // Builds index of the rects, previous contents of the index are replaced
+    void build(std::vector<SkRect> rects);
+
+    // Appends to the result indices of all rects that contain the point,
+    // including points on the edges of the rects. Indices are not sorted.
+    void query(SkPoint point, std::vector<int>* result) const;
+
+    int size() const { return rects.size(); };
+
+  private:
+    struct Node {
+        SkRect bounds;
+        // Range of the `order` that contains rects of the leaf node
+        int start;
+        int count;
+        // Indices of the child nodes, or -1 when node is leaf
+        int left = -1;
+        int right = -1;
+    };
+
+    int build_node(int start, int count);
+
+    std::vector<SkRect> rects;
+    // Indices of the rects ordered so that every node has continuous range
+    std::vector<int> order;
+    std::vector<Node> nodes;
+};
+
+}  // namespace aardvark
@@ -1,26 +1,69 @@
 #pragma once
 
-#include <vector>
+#include <functional>
 #include <memory>
+#include <vector>
 #include "SkMatrix.h"
 #include "../element.hpp"
 #include "../document.hpp"
+#include "hit_test_index.hpp"
 
 namespace aardvark {
 
 class Element;
 class Document;
 
+// Elements inside of the repaint boundary with their bounds relative to the
+// position of the boundary. Nested repaint boundaries have their own index.
+struct BoundaryHitTestIndex {
+    struct Entry {
+        Element* elem;
+        // Position relative to the boundary
+        Position offset;
+        // Index of the closest entry with clip among the element and its
+        // ancestors inside of the boundary, or -1
+        int clip_entry;
+        // Same for the parent of the element
+        int parent_clip_entry;
+        // Index after the entries of the descendants of the element
+        int end_entry;
+    };
+
+    // Whether the index is up-to-date with the layout
+    bool is_valid = false;
+    // Entries in paint order, first entry is the boundary itself
+    std::vector<Entry> entries;
+    // Bounds of the entries that are not repaint boundaries
+    HitTestIndex index;
+    // Indices of the entries of the rects in the index
+    std::vector<int> indexed_entries;
+    // Entries that are nested repaint boundaries
+    std::vector<int> boundaries;
+};
+
 class HitTester {
   public:
     HitTester(Document* document) : document(document){};
+
+    // Returns elements with responders under the pointer, ordered from top
+    // to bottom according to their hit test modes.
     std::vector<std::weak_ptr<Element>> test(float left, float top);
 
+    // Marks index of the closest repaint boundary of the element as outdated
+    static void invalidate(Element* elem);
+
   private:
     Document* document;
-    void test_element(std::shared_ptr<Element> elem, float left, float top);
-    SkMatrix transform;
+    // Tests elements inside of repaint boundary. Point is relative to the
+    // position of the boundary before its transform is applied. Parent hit is
+    // the index of the closest hit ancestor of the boundary, or -1.
+    void test_boundary(Element* boundary, SkPoint point, int parent_hit);
+    void build_index(Element* boundary, BoundaryHitTestIndex* index);
+    bool is_clipped(
+        BoundaryHitTestIndex* index, int entry_index, SkPoint point);
     std::vector<std::shared_ptr<Element>> elements_under_pointer;
+    // Index of the closest hit ancestor of each element under pointer, or -1
+    std::vector<int> hit_parents;
 };
 
 }
@@ -14,6 +14,15 @@ class Element;
 class Document;
 class HitTester;
 
+struct PointerEventStats {
+    // Move events received from the platform
+    int raw_move_events = 0;
+    // Move events dispatched to the handlers
+    int dispatched_move_events = 0;
+    // Move events that were merged into other move events
+    int coalesced_move_events = 0;
+};
+
 // Class that controls handling of document pointer events
 class PointerEventManager {
   public:
@@ -28,8 +37,19 @@ class PointerEventManager {
     std::shared_ptr<Connection> start_tracking_pointer(
         const int pointer_id, const PointerEventHandler& handler);
 
+    // Move events are not dispatched immediately, but are merged with other
+    // move events of the same pointer until the next frame or until some
+    // other event is received. Other events are dispatched immediately.
     void handle_event(const PointerEvent& event);
 
+    // Dispatches pending move events. Document calls this before layout.
+    void flush_pending_events();
+
+    // When disabled, move events are dispatched immediately
+    bool coalesce_move_events = true;
+
+    PointerEventStats stats;
+
   private:
     Document* document;
 
@@ -37,8 +57,12 @@ class PointerEventManager {
     nod::signal<void(const PointerEvent&)> after_signal;
     std::map<int, nod::signal<void(const PointerEvent&)>> pointers_signals;
 
+    // Merged move events that are waiting for the next frame, by pointer id
+    std::map<int, PointerEvent> pending_moves;
+
     std::unique_ptr<HitTester> hit_tester;
     std::unordered_map<int, std::vector<std::weak_ptr<Element>>> prev_hit_elems;
+    void dispatch_event(const PointerEvent& event);
     void call_responders_handlers(const PointerEvent& event);
 };
 
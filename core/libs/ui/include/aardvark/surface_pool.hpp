@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "GrDirectContext.h"
+#include "SkSurface.h"
+#include "base_types.hpp"
+#include "layer.hpp"
+
+namespace aardvark {
+
+struct SurfacePoolStats {
+    // Number of layers that were created using surfaces from the pool
+    int64_t hits = 0;
+    // Number of layers that required allocating new surface
+    int64_t misses = 0;
+    // Number of surfaces that were freed to stay within the budget
+    int64_t evictions = 0;
+    // Number of surfaces and their size in bytes currently kept in the pool
+    int resident_count = 0;
+    size_t resident_bytes = 0;
+};
+
+// Pool of offscreen surfaces that can be reused by layers of any repaint
+// boundary. Sizes of the surfaces are rounded up to buckets, so layers with
+// slightly different sizes, for example during resize animation, can reuse
+// the same surfaces. Unused surfaces are kept within the budget, least
+// recently released surfaces are evicted first.
+class SurfacePool {
+  public:
+    static constexpr size_t DEFAULT_BUDGET = 64 * 1024 * 1024;
+
+    SurfacePool(
+        sk_sp<GrDirectContext> gr_context, size_t budget = DEFAULT_BUDGET);
+
+    // Returns cleared layer of the specified size. Surface of the layer can be
+    // larger than the requested size.
+    std::shared_ptr<Layer> acquire(Size size);
+
+    // Returns surface of the layer to the pool. Layer should be moved here,
+    // surface is not reused when there are other references to the layer.
+    void release(std::shared_ptr<Layer> layer);
+
+    // Checks whether surface of the layer can be used for the layer of the
+    // specified size.
+    static bool fits(Layer* layer, Size size);
+
+    // Returns size of the used area of the layer, it is truncated to whole
+    // pixels.
+    static Size layer_size(Size size);
+
+    // Returns size of the surface that is allocated for the layer of the
+    // specified size.
+    static SkISize bucket_size(Size size);
+
+    // Sets maximal size in bytes of the unused surfaces kept in the pool
+    void set_budget(size_t budget);
+
+    size_t get_budget() { return budget; };
+
+    // Frees all unused surfaces
+    void clear();
+
+    SurfacePoolStats stats;
+
+  private:
+    struct Entry {
+        uint64_t key;
+        sk_sp<SkSurface> surface;
+        size_t bytes;
+    };
+    using EntriesList = std::list<Entry>;
+
+    // Evicts least recently used surfaces until pool fits in the budget
+    void trim(size_t max_bytes);
+    void erase(EntriesList::iterator it);
+
+    sk_sp<GrDirectContext> gr_context;
+    size_t budget;
+    // Unused surfaces, most recently released first
+    EntriesList entries;
+    std::unordered_map<uint64_t, std::vector<EntriesList::iterator>> buckets;
+};
+
+}  // namespace aardvark
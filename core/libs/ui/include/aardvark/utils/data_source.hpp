@@ -1,36 +1,94 @@
 #pragma once
 
+#include <memory>
 #include <string>
+#include <string_view>
 
+#include "SkData.h"
 #include "files_utils.hpp"
 
 namespace aardvark {
 
+// View of the data, it is valid while the data is alive
+inline std::string_view view_data(const sk_sp<SkData>& data) {
+    return std::string_view(
+        static_cast<const char*>(data->data()), data->size());
+}
+
+// Wraps string into the data without copying
+inline sk_sp<SkData> make_string_data(std::string str) {
+    auto owned = new std::string(std::move(str));
+    return SkData::MakeWithProc(
+        owned->data(),
+        owned->size(),
+        [](const void* ptr, void* ctx) {
+            delete static_cast<std::string*>(ctx);
+        },
+        owned);
+}
+
 class DataSource {
   public:
-    virtual std::string get_data() = 0;
+    // Returns data without copying when the source allows it. Data is
+    // immutable, so it can be shared between consumers and threads.
+    virtual sk_sp<SkData> get_sk_data() = 0;
+
+    // Returns copy of the data
+    virtual std::string get_data() {
+        return std::string(view_data(get_sk_data()));
+    };
+
+    // Identifies contents of the source, so sources with the same contents can
+    // share cached results. Empty key means that only this source has them.
+    virtual std::string get_key() { return ""; };
 };
 
+// File that is read again on each request
 class File : public DataSource {
   public:
     File(std::string path) : path(std::move(path)){};
 
+    sk_sp<SkData> get_sk_data() override {
+        return make_string_data(get_data());
+    };
+
     std::string get_data() override {
         return utils::read_text_file(path);
     };
 
+    std::string get_key() override { return "file:" + path; };
+
+  private:
+    std::string path;
+};
+
+struct FileMapping;
+
+// File that is mapped into memory read-only. All sources of the same path
+// share one mapping while some of them are alive, and data returned by them
+// keeps the mapping alive. File should not be modified while it is mapped.
+// When file can not be mapped, data is empty.
+class MappedFile : public DataSource {
+  public:
+    MappedFile(std::string path) : path(std::move(path)){};
+
+    sk_sp<SkData> get_sk_data() override;
+
+    std::string get_key() override { return "file:" + path; };
+
   private:
     std::string path;
+    std::shared_ptr<FileMapping> mapping;
 };
 
 class StringSrc : public DataSource {
   public:
-    StringSrc(std::string data) : data(std::move(data)){};
+    StringSrc(std::string data) : data(make_string_data(std::move(data))){};
 
-    std::string get_data() override { return data; };
+    sk_sp<SkData> get_sk_data() override { return data; };
 
   private:
-    std::string data;
+    sk_sp<SkData> data;
 };
 
 }
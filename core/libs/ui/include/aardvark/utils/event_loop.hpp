@@ -1,8 +1,11 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <functional>
 #include <unordered_map>
 #include <mutex>
+#include <optional>
 #include "boost/asio.hpp"
 
 namespace aardvark {
@@ -19,6 +22,35 @@ class EventLoop {
     void run() { io.run(); };
     void stop() { io.stop(); };
 
+    // Returns time when the earliest of the active timeouts expires
+    std::optional<std::chrono::steady_clock::time_point> get_next_expiry();
+
+    // Checks whether there are posted callbacks that are not called yet
+    bool has_pending_callbacks();
+
+    // Wraps completion handler of an asynchronous operation that is started
+    // directly on the `io`, so the loop knows that the operation is pending.
+    template <typename Handler>
+    auto track_io(Handler&& handler) {
+        pending_io++;
+        return [this, handler = std::forward<Handler>(handler)](
+                   auto&&... args) mutable {
+            pending_io--;
+            handler(std::forward<decltype(args)>(args)...);
+        };
+    }
+
+    // Checks whether there are asynchronous operations on the `io` that are
+    // not completed yet. Completion of such operation does not call the
+    // `wakeup_handler`, so the owner of the loop should check the `io`
+    // periodically while this is true.
+    bool has_pending_io() { return pending_io > 0; }
+
+    // Called from any thread when new callback or timeout is added to the
+    // loop. This allows owner of the loop, that waits for the platform events,
+    // to wake up.
+    Callback wakeup_handler;
+
     boost::asio::io_context io = boost::asio::io_context();
 
   private:
@@ -27,6 +59,10 @@ class EventLoop {
     int id = 0;
     std::unordered_map<int, Callback> callbacks;
     std::mutex callbacks_mutex;
+    std::atomic<int> pending_io{0};
+    void wakeup() {
+        if (wakeup_handler) wakeup_handler();
+    }
 };
 
 } // namespace aardvark
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace aardvark {
+
+// Records durations of the phases of frames and per-frame counters into the
+// fixed-size ring buffer, that can be exported in the Chrome trace format
+// (it can be opened in `chrome://tracing` or Perfetto). Recording is lock-free
+// and can be done from any thread. When profiler is disabled, recording
+// costs a single atomic load.
+class Profiler {
+  public:
+    // Number of records kept in the buffer, older records are overwritten
+    static constexpr int CAPACITY = 1 << 16;
+
+    // Starts recording, buffer is allocated on the first call
+    static void enable();
+
+    // Stops recording, recorded data is kept until it is cleared
+    static void disable();
+
+    static bool is_enabled();
+
+    // Removes all recorded data
+    static void clear();
+
+    // Returns current time in microseconds since the start of the profiler
+    static int64_t now();
+
+    // Records phase that started and ended at the specified time. Name should
+    // be a string literal, because only pointer to it is stored.
+    static void record_phase(const char* name, int64_t start, int64_t end);
+
+    // Records value of the counter at the current time. Name should be a
+    // string literal.
+    static void record_counter(const char* name, int64_t value);
+
+    // Returns recorded data as JSON in the Chrome trace event format
+    static std::string get_chrome_trace();
+
+    // Writes recorded data in the Chrome trace event format to the file.
+    // Returns `false` when file could not be written.
+    static bool save_chrome_trace(const std::string& path);
+};
+
+// Records phase that lasts until the end of the scope
+class ProfilerScope {
+  public:
+    explicit ProfilerScope(const char* name)
+        : name(name), start(Profiler::is_enabled() ? Profiler::now() : -1){};
+
+    ~ProfilerScope() {
+        if (start != -1) Profiler::record_phase(name, start, Profiler::now());
+    };
+
+    ProfilerScope(const ProfilerScope&) = delete;
+    ProfilerScope& operator=(const ProfilerScope&) = delete;
+
+  private:
+    const char* name;
+    int64_t start;
+};
+
+}  // namespace aardvark
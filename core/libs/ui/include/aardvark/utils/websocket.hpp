@@ -6,6 +6,8 @@
 #include <boost/asio.hpp>
 #include <boost/beast.hpp>
 
+#include "event_loop.hpp"
+
 namespace aardvark {
 
 namespace asio = boost::asio;
@@ -15,8 +17,12 @@ enum class WebsocketState { connecting, open, closing, closed };
 
 class Websocket : public std::enable_shared_from_this<Websocket> {
   public:
-    Websocket(asio::io_context& io, std::string host, std::string port)
-        : resolver(io), ws(io), host(host), port(port){};
+    Websocket(EventLoop& event_loop, std::string host, std::string port)
+        : event_loop(event_loop),
+          host(host),
+          port(port),
+          resolver(event_loop.io),
+          ws(event_loop.io){};
 
     void open();
     void close();
@@ -30,12 +36,20 @@ class Websocket : public std::enable_shared_from_this<Websocket> {
     nod::signal<void()> close_signal;
 
   private:
+    EventLoop& event_loop;
     std::string host;
     std::string port;
     asio::ip::tcp::resolver resolver;
     beast::websocket::stream<beast::tcp_stream> ws;
     beast::flat_buffer buffer;
 
+    // Binds completion handler to this object and tracks it in the event loop
+    template <typename Method>
+    auto bind(Method method) {
+        return event_loop.track_io(
+            beast::bind_front_handler(method, shared_from_this()));
+    }
+
     void on_resolve(beast::error_code error,
                     asio::ip::tcp::resolver::results_type results);
     void on_connect(beast::error_code error,
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace aardvark {
+
+// Pool of threads for running batches of independent tasks. Every thread has
+// its own queue of tasks, and when it is empty, the thread steals tasks from
+// the queues of other threads, so uneven tasks are balanced between threads.
+class WorkStealingPool {
+  public:
+    // Creates pool with the specified number of threads in addition to the
+    // calling thread. By default, uses one thread per core.
+    WorkStealingPool(int threads = default_threads());
+    ~WorkStealingPool();
+
+    // Calls `task` for each index from 0 to `count - 1` and blocks until all
+    // calls are completed. Calling thread also runs tasks. Must not be called
+    // from the tasks.
+    void parallel_for(int count, const std::function<void(int)>& task);
+
+    // Number of threads including the calling thread
+    int size() const { return workers.size(); };
+
+    static int default_threads();
+
+  private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<int> tasks;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    const std::function<void(int)>* current_task = nullptr;
+    std::atomic<int> remaining_tasks{0};
+    std::mutex mutex;
+    std::condition_variable start_condition;
+    std::condition_variable done_condition;
+    int generation = 0;
+    bool stopped = false;
+
+    void thread_main(int worker_index);
+    bool take_task(int worker_index, int* task_index);
+    void run_tasks(int worker_index);
+};
+
+}  // namespace aardvark
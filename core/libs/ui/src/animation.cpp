@@ -0,0 +1,92 @@
+#include "animation.hpp"
+
+#include <cmath>
+
+namespace aardvark {
+
+float ease(AnimationEasing easing, float progress) {
+    auto p = progress;
+    switch (easing) {
+        case AnimationEasing::linear:
+            return p;
+        case AnimationEasing::ease_in:
+            return p * p * p;
+        case AnimationEasing::ease_out:
+            return 1 - powf(1 - p, 3);
+        case AnimationEasing::ease_in_out:
+            return p < 0.5 ? 4 * p * p * p : 1 - powf(-2 * p + 2, 3) / 2;
+    }
+    return p;
+}
+
+Animation::Animation(const AnimationOptions& options, float from)
+    : options(options), from(from){};
+
+float Animation::value_at(double time) {
+    switch (options.type) {
+        case AnimationType::timing:
+            return timing_value_at(time);
+        case AnimationType::spring:
+            return spring_value_at(time);
+        case AnimationType::decay:
+            return decay_value_at(time);
+    }
+    return from;
+}
+
+float Animation::timing_value_at(double time) {
+    if (time >= options.duration) {
+        is_done = true;
+        return options.to;
+    }
+    auto progress = static_cast<float>(time / options.duration);
+    return from + (options.to - from) * ease(options.easing, progress);
+}
+
+// Analytic solution of the damped harmonic oscillator
+float Animation::spring_position(double t) {
+    auto& o = options;
+    double omega0 = sqrt(o.stiffness / o.mass);
+    double zeta = o.damping / (2 * sqrt(o.stiffness * o.mass));
+    double x0 = o.to - from;
+    double v0 = -o.velocity;
+    if (zeta < 1) {
+        // Underdamped
+        auto omega1 = omega0 * sqrt(1 - zeta * zeta);
+        auto envelope = exp(-zeta * omega0 * t);
+        return o.to - envelope * ((v0 + zeta * omega0 * x0) / omega1 *
+                                      sin(omega1 * t) +
+                                  x0 * cos(omega1 * t));
+    }
+    // Critically damped, also used for overdamped springs
+    auto envelope = exp(-omega0 * t);
+    return o.to - envelope * (x0 + (v0 + omega0 * x0) * t);
+}
+
+float Animation::spring_value_at(double time) {
+    auto seconds = time / 1000;
+    auto position = spring_position(seconds);
+    // Velocity is approximated over the last millisecond
+    auto velocity = (position - spring_position(seconds - 0.001)) / 0.001;
+    if (fabs(options.to - position) <= options.rest_threshold &&
+        fabs(velocity) <= options.rest_threshold) {
+        is_done = true;
+        return options.to;
+    }
+    return position;
+}
+
+float Animation::decay_value_at(double time) {
+    auto rate = 1 - options.deceleration;
+    // Velocity in units per millisecond
+    auto velocity = options.velocity / 1000;
+    auto distance = velocity / rate;
+    auto remaining = distance * exp(-rate * time);
+    if (fabs(remaining) <= options.rest_threshold) {
+        is_done = true;
+        return from + distance;
+    }
+    return from + distance - remaining;
+}
+
+}  // namespace aardvark
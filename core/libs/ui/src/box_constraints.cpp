@@ -35,4 +35,8 @@ BoxConstraints BoxConstraints::from_size(Size size, bool tight) {
     };
 };
 
+bool BoxConstraints::is_equal(BoxConstraints a, BoxConstraints b) {
+    return a == b;
+};
+
 }  // namespace aardvark
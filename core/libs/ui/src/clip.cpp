@@ -0,0 +1,175 @@
+#include "clip.hpp"
+
+#include "SkPathOps.h"
+
+namespace aardvark {
+
+Clip::Clip(const SkRRect& rrect) {
+    if (rrect.isRect() || rrect.isEmpty()) {
+        type = Type::rect;
+        rect = rrect.rect();
+    } else {
+        type = Type::rrect;
+        this->rrect = rrect;
+    }
+}
+
+Clip::Clip(const SkPath& path) {
+    SkRect path_rect;
+    SkRRect path_rrect;
+    if (path.isInverseFillType()) {
+        *this = make_exact_path(path);
+    } else if (path.isRect(&path_rect)) {
+        type = Type::rect;
+        rect = path_rect.makeSorted();
+    } else if (path.isOval(&path_rect)) {
+        type = Type::rrect;
+        rrect.setOval(path_rect);
+    } else if (path.isRRect(&path_rrect)) {
+        *this = Clip(path_rrect);
+    } else {
+        *this = make_exact_path(path);
+    }
+}
+
+Clip Clip::make_exact_path(const SkPath& path) {
+    auto clip = Clip();
+    clip.type = Type::path;
+    clip.path = path;
+    return clip;
+}
+
+SkRect Clip::get_bounds() const {
+    switch (type) {
+        case Type::rect:
+            return rect;
+        case Type::rrect:
+            return rrect.rect();
+        case Type::path:
+            return path.getBounds();
+    }
+    return rect;
+}
+
+SkPath Clip::to_path() const {
+    SkPath res;
+    switch (type) {
+        case Type::rect:
+            res.addRect(rect);
+            break;
+        case Type::rrect:
+            res.addRRect(rrect);
+            break;
+        case Type::path:
+            res = path;
+            break;
+    }
+    return res;
+}
+
+Clip Clip::offset(float left, float top) const {
+    switch (type) {
+        case Type::rect:
+            return Clip(rect.makeOffset(left, top));
+        case Type::rrect:
+            return Clip(rrect.makeOffset(left, top));
+        case Type::path: {
+            SkPath res;
+            path.offset(left, top, &res);
+            return make_exact_path(res);
+        }
+    }
+    return *this;
+}
+
+Clip Clip::intersect(const Clip& other) const {
+    // Path is not checked, clip that contains another one can be dropped
+    if (type == Type::rect) {
+        if (other.type == Type::rect) {
+            auto res = SkRect();
+            if (!res.intersect(rect, other.rect)) res.setEmpty();
+            return Clip(res);
+        }
+        if (rect.contains(other.get_bounds())) return other;
+    }
+    if (type == Type::rrect && other.type != Type::path &&
+        rrect.contains(other.get_bounds())) {
+        return other;
+    }
+    if (other.type == Type::rect && other.rect.contains(get_bounds())) {
+        return *this;
+    }
+    if (other.type == Type::rrect && type != Type::path &&
+        other.rrect.contains(get_bounds())) {
+        return *this;
+    }
+    SkPath res;
+    if (!Op(to_path(), other.to_path(), kIntersect_SkPathOp, &res)) {
+        return Clip();
+    }
+    return Clip(res);
+}
+
+Clip Clip::transform(const SkMatrix& matrix) const {
+    if (type == Type::rect && matrix.rectStaysRect()) {
+        return Clip(matrix.mapRect(rect));
+    }
+    SkRRect res;
+    if (type == Type::rrect && rrect.transform(matrix, &res)) return Clip(res);
+    SkPath res_path;
+    to_path().transform(matrix, &res_path);
+    return make_exact_path(res_path);
+}
+
+bool rrect_contains(const SkRRect& rrect, float left, float top) {
+    auto& bounds = rrect.rect();
+    if (!bounds.contains(left, top)) return false;
+    // Point inside of the corner box should be inside of the corner ellipse
+    auto check_corner = [&](SkRRect::Corner corner, bool is_left, bool is_top) {
+        auto radius = rrect.radii(corner);
+        if (radius.x() <= 0 || radius.y() <= 0) return true;
+        auto cx = is_left ? bounds.left() + radius.x()
+                          : bounds.right() - radius.x();
+        auto cy = is_top ? bounds.top() + radius.y()
+                         : bounds.bottom() - radius.y();
+        if ((is_left ? left >= cx : left <= cx) ||
+            (is_top ? top >= cy : top <= cy)) {
+            return true;
+        }
+        auto dx = (left - cx) / radius.x();
+        auto dy = (top - cy) / radius.y();
+        return dx * dx + dy * dy <= 1;
+    };
+    return check_corner(SkRRect::kUpperLeft_Corner, true, true) &&
+           check_corner(SkRRect::kUpperRight_Corner, false, true) &&
+           check_corner(SkRRect::kLowerRight_Corner, false, false) &&
+           check_corner(SkRRect::kLowerLeft_Corner, true, false);
+}
+
+bool Clip::contains(float left, float top) const {
+    switch (type) {
+        case Type::rect:
+            return rect.contains(left, top);
+        case Type::rrect:
+            return rrect_contains(rrect, left, top);
+        case Type::path:
+            return path.contains(left, top);
+    }
+    return false;
+}
+
+void Clip::apply(SkCanvas* canvas, bool antialias) const {
+    switch (type) {
+        case Type::rect:
+            canvas->clipRect(rect, SkClipOp::kIntersect, antialias);
+            break;
+        case Type::rrect:
+            canvas->clipRRect(rrect, SkClipOp::kIntersect, antialias);
+            break;
+        case Type::path:
+            canvas->clipPath(path, SkClipOp::kIntersect, antialias);
+            break;
+    }
+}
+
+}  // namespace aardvark
@@ -0,0 +1,25 @@
+#include "dirty_queue.hpp"
+
+namespace aardvark {
+
+void DirtyQueue::push(Element* elem, int depth) {
+    if (!queued.insert(elem).second) return;
+    heap.push(Entry{depth, order, elem});
+    order++;
+}
+
+Element* DirtyQueue::pop() {
+    auto elem = heap.top().elem;
+    heap.pop();
+    queued.erase(elem);
+    if (heap.empty()) order = 0;
+    return elem;
+}
+
+void DirtyQueue::clear() {
+    heap = decltype(heap)();
+    queued.clear();
+    order = 0;
+}
+
+}  // namespace aardvark
@@ -1,39 +1,32 @@
 #include "document.hpp"
 
-#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iterator>
 
-#include "SkPathOps.h"
 #include "elements/placeholder.hpp"
+#include "utils/profiler.hpp"
 
 namespace aardvark {
 
-SkPath offset_path(SkPath* path, Position offset) {
-    SkPath offset_path;
-    path->offset(offset.left, offset.top, &offset_path);
-    return offset_path;
-}
-
-// Add element to set ensuring that no element will be the children of another
-void add_only_parent(ElementsSet& set, Element* added) {
-    auto it = set.find(added);
-    // Already in the set
-    if (it != set.end()) return;
-    auto children_of_added = std::vector<Element*>();
-    for (auto elem : set) {
-        // Parent is in the set
-        if (elem->is_parent_of(added)) return;
-        // Child is in the set
-        if (added->is_parent_of(elem)) children_of_added.push_back(elem);
-    }
-    for (auto elem : children_of_added) set.erase(elem);
-    set.insert(added);
-};
+using Clock = std::chrono::steady_clock;
+
+// Counters of the boundary that is laid out by the current layout thread
+thread_local FrameCounters* worker_counters = nullptr;
+
+int64_t elapsed_micros(Clock::time_point start, Clock::time_point end) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(end - start)
+        .count();
+}
 
 Document::Document(
     sk_sp<GrDirectContext> gr_context,
     std::shared_ptr<Layer> screen,
     std::shared_ptr<Element> root)
-    : gr_context(std::move(gr_context)), screen(std::move(screen)) {
+    : screen(std::move(screen)),
+      surface_pool(gr_context),
+      gr_context(std::move(gr_context)) {
     pointer_event_manager = std::make_unique<PointerEventManager>(this);
     size_observer = std::make_shared<ElementObserver<Size>>(
         [](std::shared_ptr<Element> element) { return element->size; });
@@ -44,6 +37,14 @@ Document::Document(
     }
 }
 
+Document::Document(
+    std::shared_ptr<Layer> screen, std::shared_ptr<Element> root)
+    : Document(
+          /* gr_context */ nullptr, std::move(screen), std::move(root)) {
+    // Raster screen keeps its contents between frames
+    partial_compose = true;
+};
+
 void Document::set_root(std::shared_ptr<Element> new_root) {
     root = std::move(new_root);
     root->parent = nullptr;
@@ -51,78 +52,304 @@ void Document::set_root(std::shared_ptr<Element> new_root) {
     root->is_relayout_boundary = true;
     root->is_repaint_boundary = true;
     root->rel_position = Position();
+    root->needs_layout = true;
 
     auto scaled_size = screen->size.scale(1/pixel_ratio);
     root->size = scaled_size;
 
     is_initial_render = true;
+    need_full_compose = true;
+    request_frame();
 }
 
 // TODO think if need weak ptrs
-void Document::change_element(Element* elem) { changed_elements.insert(elem); }
+void Document::change_element(Element* elem) {
+    auto lock = std::lock_guard<std::mutex>(changed_elements_mutex);
+    elem->invalidate_intrinsic_size();
+    changed_elements.insert(elem);
+    HitTester::invalidate(elem);
+    request_frame();
+}
+
+void Document::change_layer(Element* elem) {
+    elem->layer_tree->is_changed = true;
+    need_recompose = true;
+    request_frame();
+}
+
+void Document::invalidate_screen() {
+    need_full_compose = true;
+    request_frame();
+}
+
+void Document::request_frame() {
+    if (request_frame_handler) request_frame_handler();
+}
 
 bool Document::render() {
-    if (is_initial_render) {
-        return initial_render();
-    } else {
-        return rerender();
-    }
+    auto profiler_scope = ProfilerScope("Document::render");
+    last_frame_counters = FrameCounters();
+    auto rendered = is_initial_render ? initial_render() : rerender();
+    if (Profiler::is_enabled()) record_frame_counters();
+    return rendered;
+}
+
+void Document::record_frame_counters() {
+    auto& counters = last_frame_counters;
+    Profiler::record_counter("elements_laid_out", counters.elements_laid_out);
+    Profiler::record_counter("elements_painted", counters.elements_painted);
+    Profiler::record_counter("layers_created", counters.layers_created);
+    Profiler::record_counter("layers_reused", counters.layers_reused);
+    Profiler::record_counter(
+        "relayout_boundaries", counters.relayout_boundaries);
+    Profiler::record_counter("layouts_skipped", counters.layouts_skipped);
+    Profiler::record_counter("repaint_boundaries", counters.repaint_boundaries);
+    Profiler::record_counter(
+        "display_lists_replayed", counters.display_lists_replayed);
+    Profiler::record_counter(
+        "repaint_boundaries_promoted", counters.repaint_boundaries_promoted);
+    Profiler::record_counter(
+        "repaint_boundaries_demoted", counters.repaint_boundaries_demoted);
+    Profiler::record_counter("icons_drawn", counters.icons_drawn);
+    Profiler::record_counter("icon_batches", counters.icon_batches);
 }
 
 bool Document::initial_render() {
-    auto scaled_size = screen->size.scale(1/pixel_ratio);
-    layout_element(
-        root.get(), BoxConstraints::from_size(scaled_size, true /* tight */));
-    update_tree_abs_position(root.get());
-    size_observer->check_all_elements();
-    if (!changed_elements.empty()) relayout();
+    auto start = Clock::now();
+    layout_pass++;
+    {
+        auto profiler_scope = ProfilerScope("Document::layout");
+        auto scaled_size = screen->size.scale(1/pixel_ratio);
+        layout_element(
+            root.get(),
+            BoxConstraints::from_size(scaled_size, true /* tight */));
+        update_tree_abs_position(root.get());
+        size_observer->check_all_elements();
+        if (!changed_elements.empty()) relayout();
+    }
+    auto layout_end = Clock::now();
 
-    current_clip = std::nullopt;
-    paint_element(root.get(), /* is_repaint_root */ true);
+    {
+        auto profiler_scope = ProfilerScope("Document::paint");
+        current_clip = std::nullopt;
+        last_frame_counters.repaint_boundaries++;
+        paint_element(root.get(), /* is_repaint_root */ true);
+    }
+    auto paint_end = Clock::now();
     compose();
+    last_frame_timings = FrameTimings{
+        elapsed_micros(start, layout_end),       // layout
+        elapsed_micros(layout_end, paint_end),   // paint
+        elapsed_micros(paint_end, Clock::now())  // compose
+    };
     is_initial_render = false;
     return true;
 }
 
 bool Document::rerender() {
+    // Coalesced pointer moves are dispatched once per frame before layout, so
+    // changes made by handlers are rendered in the same frame
+    pointer_event_manager->flush_pending_events();
+    update_animations();
+    auto start = Clock::now();
     relayout();
-    auto painted = repaint();
-    // if (need_recompose) compose();
-    compose();
-    return painted;
+    auto layout_end = Clock::now();
+    repaint();
+    auto paint_end = Clock::now();
+    auto composed = compose();
+    last_frame_timings = FrameTimings{
+        elapsed_micros(start, layout_end),       // layout
+        elapsed_micros(layout_end, paint_end),   // paint
+        elapsed_micros(paint_end, Clock::now())  // compose
+    };
+    return composed;
 }
 
 void Document::relayout() {
+    auto profiler_scope = ProfilerScope("Document::relayout");
+    layout_pass++;
+    if (need_root_relayout) relayout_root();
     for (auto elem : changed_elements) {
         if (elem->document != this) continue;
-        add_only_parent(
-            relayout_boundaries, elem->find_closest_relayout_boundary());
+        auto boundary = mark_needs_layout(elem);
+        relayout_boundaries.push(boundary, boundary->depth);
     }
     changed_elements.clear();
-    for (auto elem : relayout_boundaries) {
-        relayout_boundary_element(elem);
+    if (parallel_layout && relayout_boundaries.size() > 1) {
+        relayout_boundaries_parallel();
+    } else {
+        // Boundaries are processed from top to bottom, so when some boundary
+        // is inside of another one, it is already laid out when its turn
+        // comes.
+        while (!relayout_boundaries.empty()) {
+            auto elem = relayout_boundaries.pop();
+            if (elem->layout_pass == layout_pass) continue;
+            relayout_boundary_element(elem);
+        }
     }
-    relayout_boundaries.clear();
 
     size_observer->check_triggered_elements();
     if (!changed_elements.empty()) relayout();
 }
 
+// Marks element and its ancestors up to the closest relayout boundary as
+// needing layout, and returns that boundary.
+Element* Document::mark_needs_layout(Element* elem) {
+    auto current = elem;
+    while (true) {
+        current->needs_layout = true;
+        if (current->is_relayout_boundary || current->parent == nullptr) {
+            return current;
+        }
+        current = current->parent;
+    }
+}
+
 void Document::relayout_boundary_element(Element* elem) {
-    reset_intrinsic_queried(elem);
     layout_element(elem, elem->prev_constraints);
     update_tree_abs_position(elem);
-    add_only_parent(repaint_boundaries, elem->find_closest_repaint_boundary());
+    finish_boundary_relayout(elem);
+}
+
+// Boundaries are laid out in waves. Each wave contains boundaries that have no
+// other queued boundaries among their ancestors, so their subtrees do not
+// intersect and can be laid out at the same time. Boundaries that are inside
+// of the laid out ones are left for the next waves.
+void Document::relayout_boundaries_parallel() {
+    if (layout_pool == nullptr) {
+        layout_pool = std::make_unique<WorkStealingPool>();
+    }
+    auto pending = std::vector<Element*>();
+    while (!relayout_boundaries.empty()) {
+        pending.push_back(relayout_boundaries.pop());
+    }
+    while (!pending.empty()) {
+        auto pending_set = ElementsSet();
+        for (auto elem : pending) {
+            if (elem->layout_pass != layout_pass) pending_set.insert(elem);
+        }
+        auto wave = std::vector<Element*>();
+        auto next_pending = std::vector<Element*>();
+        for (auto elem : pending) {
+            if (elem->layout_pass == layout_pass) continue;
+            auto has_pending_ancestor = false;
+            for (auto it = elem->parent; it != nullptr; it = it->parent) {
+                if (pending_set.find(it) != pending_set.end()) {
+                    has_pending_ancestor = true;
+                    break;
+                }
+            }
+            (has_pending_ancestor ? next_pending : wave).push_back(elem);
+        }
+        // Each boundary counts its work separately, so counters do not
+        // depend on the scheduling
+        auto wave_counters = std::vector<FrameCounters>(wave.size());
+        layout_pool->parallel_for(wave.size(), [&](int i) {
+            auto elem = wave[i];
+            auto profiler_scope = ProfilerScope("Document::relayout_boundary");
+            worker_counters = &wave_counters[i];
+            layout_element(elem, elem->prev_constraints);
+            update_tree_abs_position(elem);
+            worker_counters = nullptr;
+        });
+        // Side effects are applied in the order of the queue
+        for (auto i = 0; i < wave.size(); i++) {
+            auto& counters = wave_counters[i];
+            last_frame_counters.elements_laid_out += counters.elements_laid_out;
+            last_frame_counters.layouts_skipped += counters.layouts_skipped;
+            finish_boundary_relayout(wave[i]);
+        }
+        pending = std::move(next_pending);
+    }
+}
+
+void Document::finish_boundary_relayout(Element* elem) {
+    last_frame_counters.relayout_boundaries++;
+    // Display lists of the ancestors include changed contents
+    auto repaint_boundary = elem;
+    while (true) {
+        repaint_boundary->display_list = nullptr;
+        if (repaint_boundary->is_repaint_boundary) break;
+        repaint_boundary = repaint_boundary->parent;
+    }
+    repaint_boundaries.push(repaint_boundary, repaint_boundary->depth);
+    // Hit testing can happen before the repaint
+    HitTester::invalidate(repaint_boundary);
     elem->is_changed = true;
 }
 
+// Root is not marked as changed, so only elements whose layout is changed
+// are repainted, and display lists of other elements are replayed.
+void Document::relayout_root() {
+    need_root_relayout = false;
+    layout_element(root.get(), root->prev_constraints);
+    update_tree_abs_position(root.get());
+    clear_changed_display_lists(root.get(), root.get());
+}
+
+// Clears display lists of the elements that were resized or moved relative to
+// their repaint boundary, and of their ancestors, because display lists of the
+// ancestors include them. Only children of the elements that were laid out in
+// the current pass can be changed. Returns whether the element is changed.
+bool Document::clear_changed_display_lists(Element* elem, Element* boundary) {
+    if (elem->is_repaint_boundary) boundary = elem;
+    auto offset = Position{
+        elem->abs_position.left - boundary->abs_position.left,  // left
+        elem->abs_position.top - boundary->abs_position.top     // top
+    };
+    auto is_changed = elem->display_list == nullptr ||
+                      elem->display_list_offset != offset ||
+                      elem->display_list_size != elem->prev_size;
+    if (elem->layout_pass == layout_pass) {
+        elem->visit_children([&](std::shared_ptr<Element>& child) {
+            auto is_child_changed =
+                clear_changed_display_lists(child.get(), boundary);
+            // Nested boundaries are painted into separate layers
+            if (is_child_changed && !child->is_repaint_boundary) {
+                is_changed = true;
+            }
+        });
+    }
+    if (is_changed) {
+        elem->display_list = nullptr;
+        if (elem->is_repaint_boundary) {
+            repaint_boundaries.push(elem, elem->depth);
+        }
+    }
+    return is_changed;
+}
+
+// Layout threads count their work separately
+FrameCounters& Document::get_layout_counters() {
+    return worker_counters == nullptr ? last_frame_counters : *worker_counters;
+}
+
 void Document::update_tree_abs_position(Element* elem) {
+    auto prev_abs_position = elem->abs_position;
     update_abs_position(elem);
+    // Relative positions of children are only changed by the layout, so when
+    // the layout was skipped and element is not moved, positions of the
+    // children are up-to-date.
+    if (elem->layout_pass != layout_pass &&
+        elem->abs_position == prev_abs_position) {
+        return;
+    }
+    // Children of the laid out boundary could be moved or resized
+    if (elem->is_repaint_boundary && elem->layout_pass == layout_pass) {
+        HitTester::invalidate(elem);
+    }
     elem->visit_children([this](std::shared_ptr<Element>& child) {
         update_tree_abs_position(child.get());
     });
 }
 
+void Document::update_tree_depth(Element* elem, int depth) {
+    elem->depth = depth;
+    elem->visit_children([this, depth](std::shared_ptr<Element>& child) {
+        update_tree_depth(child.get(), depth + 1);
+    });
+}
+
 void Document::update_abs_position(Element* elem) {
     elem->abs_position =
         elem->parent == nullptr
@@ -130,29 +357,47 @@ void Document::update_abs_position(Element* elem) {
             : Position::add(elem->parent->abs_position, elem->rel_position);
 }
 
-void Document::reset_intrinsic_queried(Element* elem) {
-    elem->intrinsic_queried = false;
-    elem->visit_children([this](std::shared_ptr<Element>& child) {
-        reset_intrinsic_queried(child.get());
-    });
-}
-
 Size Document::layout_element(Element* elem, BoxConstraints constraints) {
+    auto depth = elem->parent == nullptr ? 0 : elem->parent->depth + 1;
+    // Layout of the element and its subtree would give the same result
+    if (!elem->needs_layout && constraints == elem->prev_constraints) {
+        // Element could be moved to another parent
+        if (elem->depth != depth) update_tree_depth(elem, depth);
+        get_layout_counters().layouts_skipped++;
+        return elem->prev_size;
+    }
     size_observer->trigger_element(elem->shared_from_this());
+    elem->depth = depth;
+    elem->layout_pass = layout_pass;
+    get_layout_counters().elements_laid_out++;
     auto size = elem->layout(constraints);
     elem->is_relayout_boundary =
         !elem->intrinsic_queried &&
         (constraints.is_tight() || elem->size_depends_on_parent);
+    // Parents query intrinsic size of the element before its layout
+    elem->intrinsic_queried = false;
     elem->prev_constraints = constraints;
+    elem->prev_size = size;
+    elem->needs_layout = false;
     return size;
 }
 
 bool Document::repaint() {
     if (repaint_boundaries.empty()) return false;
-    for (auto elem : repaint_boundaries) {
+    auto profiler_scope = ProfilerScope("Document::repaint");
+    update_repaint_boundaries();
+    paint_pass++;
+    // Boundaries that were repainted as part of their ancestors are skipped
+    while (!repaint_boundaries.empty()) {
+        auto elem = repaint_boundaries.pop();
+        // Element could be demoted after it was queued
+        if (!elem->is_repaint_boundary) {
+            elem = elem->find_closest_repaint_boundary();
+        }
+        if (elem->paint_pass == paint_pass) continue;
+        last_frame_counters.repaint_boundaries++;
         paint_element(elem, /* is_repaint_root */ true);
     }
-    repaint_boundaries.clear();
     return true;
 }
 
@@ -167,7 +412,7 @@ void Document::partial_relayout(Element* elem) {
     }
 
     if (changed_it != changed_elements.end()) {
-        auto boundary = (*changed_it)->find_closest_relayout_boundary();
+        auto boundary = mark_needs_layout(*changed_it);
         relayout_boundary_element(boundary);
         changed_elements.erase(changed_it);
         // TODO should erase from `changed` all elements that are children
@@ -176,8 +421,9 @@ void Document::partial_relayout(Element* elem) {
 }
 
 void Document::paint_element(Element* elem, bool is_repaint_root) {
-    // std::cout << "paint element: " << elem->get_debug_name() << std::endl;
     current_element = elem;
+    elem->paint_pass = paint_pass;
+    if (repaint_boundary_tuning.enabled) count_repaint(elem, is_repaint_root);
 
     /*
     TODO
@@ -193,10 +439,16 @@ void Document::paint_element(Element* elem, bool is_repaint_root) {
     // Layers from previous layer tree of the current repaint boundary element
     std::vector<LayerTreeNode> prev_layers_pool;
     if (elem->is_repaint_boundary) {
+        // Icons of the parent boundary are drawn into its layer
+        flush_icons();
         if (!is_repaint_root && current_layer_tree != nullptr) {
+            // Contents painted before the nested boundary go below its layers
+            paint_directly(elem->parent);
             current_layer_tree->add(elem->layer_tree.get());
         }
         current_layer_tree = elem->layer_tree.get();
+        current_layer_tree->is_changed = true;
+        HitTester::invalidate(elem);
         prev_layers_pool = std::move(layers_pool);
         layers_pool = std::move(current_layer_tree->children);
         current_layer = nullptr;
@@ -205,39 +457,67 @@ void Document::paint_element(Element* elem, bool is_repaint_root) {
     // Clipping
     auto prev_clip = current_clip;
     if (elem->clip != std::nullopt) {
+        flush_icons();
         // Offset clip to position of the clipped element
-        SkPath offset_clip =
-            offset_path(&elem->clip.value(), elem->abs_position);
+        auto offset_clip = elem->clip.value().offset(
+            elem->abs_position.left, elem->abs_position.top);
         if (current_clip == std::nullopt) {
             current_clip = offset_clip;
         } else {
             // Intersect prev clip with element's clip and make it new
             // current clip
-            Op(current_clip.value(),
-               offset_clip,
-               kIntersect_SkPathOp,
-               &current_clip.value());
+            current_clip = current_clip.value().intersect(offset_clip);
         }
     }
     // When element is repaint boundary, current clip is not used while
     // painting, instead it is stored in the layer tree and applied while
     // compositing.
-    if (elem->is_repaint_boundary && current_clip != std::nullopt) {
-        // Offset clip to the position of the layer
-        current_layer_tree->clip = offset_path(
-            &current_clip.value(),
-            Position{-elem->abs_position.left, -elem->abs_position.top});
-        current_clip = std::nullopt;
+    if (elem->is_repaint_boundary) {
+        if (current_clip != std::nullopt) {
+            // Offset clip to the position of the layer
+            current_layer_tree->set_clip(current_clip.value().offset(
+                -elem->abs_position.left, -elem->abs_position.top));
+            current_clip = std::nullopt;
+        } else if (!is_repaint_root) {
+            // Repaint root keeps the clip set by the parent boundary
+            current_layer_tree->set_clip(std::nullopt);
+        }
     }
 
     auto prev_inside_changed = inside_changed;
     inside_changed = inside_changed || elem->is_changed;
-    elem->paint(inside_changed);
+    auto layer_pos = current_layer_tree->element->abs_position;
+    auto offset = Position{
+        elem->abs_position.left - layer_pos.left,  // left
+        elem->abs_position.top - layer_pos.top     // top
+    };
+    if (!inside_changed && elem->display_list != nullptr &&
+        elem->display_list_offset == offset) {
+        last_frame_counters.display_lists_replayed++;
+        draw_display_list(elem->display_list);
+    } else {
+        last_frame_counters.elements_painted++;
+        elem->display_list = nullptr;
+        auto record = record_display_lists && !elem->paints_directly;
+        elem->paints_directly = false;
+        if (record) start_recording(elem);
+        elem->paint(inside_changed);
+        // Recording is flushed when the element contains repaint boundary
+        if (record && !recordings.empty() && recordings.back()->elem == elem) {
+            elem->display_list = finish_recording();
+            elem->display_list_offset = offset;
+            elem->display_list_size = elem->prev_size;
+            draw_display_list(elem->display_list);
+        }
+    }
     elem->is_changed = false;
     inside_changed = prev_inside_changed;
 
+    if (elem->clip != std::nullopt) flush_icons();
     current_clip = prev_clip;  // Restore clip
     if (elem->is_repaint_boundary) {
+        flush_icons();
+        release_layers(layers_pool);
         layers_pool = std::move(prev_layers_pool);
         current_layer_tree = current_layer_tree->parent;
         current_layer = nullptr;
@@ -245,7 +525,405 @@ void Document::paint_element(Element* elem, bool is_repaint_root) {
     current_element = elem->parent;
 }
 
+SkCanvas* Document::get_canvas(Element* elem) {
+    if (recordings.empty()) {
+        auto layer = get_layer();
+        setup_layer(layer, elem);
+        return layer->canvas;
+    }
+    // Recordings are made in unscaled coordinates of the layer, so they can be
+    // replayed with any pixel ratio
+    auto canvas = recordings.back()->canvas;
+    canvas->restoreToCount(1);
+    canvas->save();
+    auto layer_pos = current_layer_tree->element->abs_position;
+    if (current_clip != std::nullopt) {
+        current_clip.value()
+            .offset(-layer_pos.left, -layer_pos.top)
+            .apply(canvas);
+    }
+    canvas->translate(
+        elem->abs_position.left - layer_pos.left,
+        elem->abs_position.top - layer_pos.top);
+    return canvas;
+}
+
+void Document::start_recording(Element* elem) {
+    auto recording = std::make_unique<DisplayListRecording>();
+    recording->elem = elem;
+    // Nothing can be painted outside of the layer of the repaint boundary
+    auto layer_size = current_layer_tree->element->size;
+    recording->canvas = recording->recorder.beginRecording(
+        SkRect::MakeWH(layer_size.width, layer_size.height));
+    recordings.push_back(std::move(recording));
+}
+
+sk_sp<SkPicture> Document::finish_recording() {
+    auto recording = std::move(recordings.back());
+    recordings.pop_back();
+    return recording->recorder.finishRecordingAsPicture();
+}
+
+// Paints contents of the unfinished recordings into the layer. These
+// recordings are discarded, and their elements continue to paint directly.
+// Empty recordings are not drawn, so they do not interrupt batches of icons.
+void Document::flush_recordings() {
+    auto picture = sk_sp<SkPicture>();
+    while (!recordings.empty()) {
+        auto canvas = recordings.back()->canvas;
+        if (picture != nullptr) {
+            canvas->restoreToCount(1);
+            canvas->drawPicture(picture);
+        }
+        picture = finish_recording();
+        if (picture != nullptr && picture->approximateOpCount() == 0) {
+            picture = nullptr;
+        }
+    }
+    if (picture != nullptr) draw_display_list(picture);
+}
+
+// Element and its ancestors inside of the current boundary stop recording
+// display lists, so their contents can be painted directly into the layer
+void Document::paint_directly(Element* elem) {
+    flush_recordings();
+    for (auto it = elem; it != nullptr; it = it->parent) {
+        it->paints_directly = true;
+        if (it == current_layer_tree->element) break;
+    }
+}
+
+bool Document::draw_icon(
+    Element* elem, const sk_sp<SkImage>& image, SkRect rect) {
+    // Icons are drawn with uniform scale
+    auto scale = rect.width() / image->width();
+    if (std::abs(image->height() * scale - rect.height()) > 1) return false;
+    auto icon = icon_atlas.get_icon(image, paint_pass);
+    if (icon == std::nullopt) return false;
+    // Display lists of the elements would split icons into separate batches
+    paint_directly(elem);
+    if (icon_batches.empty()) icon_batches_clip = current_clip;
+    auto batch = std::find_if(
+        icon_batches.begin(), icon_batches.end(), [&](IconBatch& batch) {
+            return batch.page == icon->page;
+        });
+    if (batch == icon_batches.end()) {
+        icon_batches.push_back(IconBatch{icon->page});
+        batch = std::prev(icon_batches.end());
+    }
+    auto layer_pos = current_layer_tree->element->abs_position;
+    batch->xforms.push_back(SkRSXform::Make(
+        scale,                                                   // scos
+        0,                                                       // ssin
+        elem->abs_position.left - layer_pos.left + rect.left(),  // tx
+        elem->abs_position.top - layer_pos.top + rect.top()      // ty
+        ));
+    batch->rects.push_back(icon->rect);
+    last_frame_counters.icons_drawn++;
+    return true;
+}
+
+// Draws collected icons into the current layer, one batch per page of the
+// atlas
+void Document::flush_icons() {
+    if (icon_batches.empty()) return;
+    auto batches = std::move(icon_batches);
+    icon_batches.clear();
+    auto canvas = get_layer()->canvas;
+    canvas->restoreToCount(1);
+    canvas->save();
+    canvas->scale(pixel_ratio, pixel_ratio);
+    auto layer_pos = current_layer_tree->element->abs_position;
+    if (icon_batches_clip != std::nullopt) {
+        icon_batches_clip.value()
+            .offset(-layer_pos.left, -layer_pos.top)
+            .apply(canvas);
+    }
+    for (auto& batch : batches) {
+        canvas->drawAtlas(
+            batch.page->get_image().get(),
+            batch.xforms.data(),
+            batch.rects.data(),
+            nullptr,  // colors
+            (int)batch.xforms.size(),
+            SkBlendMode::kSrcOver,
+            SkSamplingOptions(SkFilterMode::kLinear),
+            nullptr,  // cullRect
+            nullptr   // paint
+        );
+        last_frame_counters.icon_batches++;
+    }
+}
+
+// Draws display list into the recording of the parent, or into the layer when
+// nothing is recorded
+void Document::draw_display_list(const sk_sp<SkPicture>& display_list) {
+    if (!recordings.empty()) {
+        auto canvas = recordings.back()->canvas;
+        canvas->restoreToCount(1);
+        canvas->drawPicture(display_list);
+        return;
+    }
+    auto layer = get_layer();
+    layer->canvas->restoreToCount(1);
+    layer->canvas->save();
+    layer->canvas->scale(pixel_ratio, pixel_ratio);
+    layer->canvas->drawPicture(display_list);
+}
+
+void Document::set_pixel_ratio(float ratio) {
+    if (ratio == pixel_ratio) return;
+    pixel_ratio = ratio;
+    if (root == nullptr) return;
+    auto scaled_size = screen->size.scale(1/pixel_ratio);
+    root->size = scaled_size;
+    if (is_initial_render) return;
+    root->needs_layout = true;
+    root->prev_constraints =
+        BoxConstraints::from_size(scaled_size, true /* tight */);
+    need_root_relayout = true;
+    // Whole tree is repainted, but unchanged elements are only replayed
+    repaint_boundaries.push(root.get(), root->depth);
+    need_full_compose = true;
+    request_frame();
+}
+
+// Counts repaints of the element and adds it to candidates for promotion or
+// demotion when it reaches the thresholds
+void Document::count_repaint(Element* elem, bool is_repaint_root) {
+    auto& stats = elem->repaint_stats;
+    auto& tuning = repaint_boundary_tuning;
+    if (paint_pass - stats.window_start >= tuning.window) {
+        stats.window_start = paint_pass;
+        stats.changes = 0;
+        stats.repaints_alone = 0;
+        stats.repaints_with_parent = 0;
+    }
+    if (stats.is_candidate) return;
+    if (elem->is_repaint_boundary) {
+        if (elem == root.get()) return;
+        if (is_repaint_root) {
+            stats.repaints_alone++;
+        } else {
+            stats.repaints_with_parent++;
+        }
+        auto repaints = stats.repaints_alone + stats.repaints_with_parent;
+        stats.is_candidate =
+            repaints >= tuning.demote_min_repaints &&
+            stats.repaints_with_parent >= tuning.demote_min_ratio * repaints;
+    } else if (elem->is_changed) {
+        stats.changes++;
+        stats.is_candidate =
+            !stats.is_demoted && stats.changes >= tuning.promote_min_changes;
+    }
+    if (stats.is_candidate) {
+        repaint_boundary_candidates.push_back(elem->weak_from_this());
+    }
+}
+
+// Applies changes of the repaint boundaries before the paint pass, so the
+// affected boundaries are repainted during the same pass
+void Document::update_repaint_boundaries() {
+    auto candidates = std::move(repaint_boundary_candidates);
+    repaint_boundary_candidates.clear();
+    for (auto& elem_wptr : candidates) {
+        auto elem = elem_wptr.lock();
+        if (elem == nullptr) continue;
+        elem->repaint_stats.is_candidate = false;
+        if (elem->document != this || !repaint_boundary_tuning.enabled) {
+            continue;
+        }
+        if (elem->is_repaint_boundary) {
+            if (can_demote(elem.get())) demote_repaint_boundary(elem.get());
+        } else {
+            if (can_promote(elem.get())) promote_repaint_boundary(elem.get());
+        }
+    }
+}
+
+bool Document::can_promote(Element* elem) {
+    if (elem->parent == nullptr || elem->is_repaint_boundary_fixed) {
+        return false;
+    }
+    auto& tuning = repaint_boundary_tuning;
+    if (repaint_boundary_stats.promoted >= tuning.max_promoted) return false;
+    auto boundary = elem->find_closest_repaint_boundary();
+    auto area = elem->size.width * elem->size.height;
+    auto boundary_area = boundary->size.width * boundary->size.height;
+    return area > 0 && area <= boundary_area * tuning.promote_max_area_ratio;
+}
+
+// Boundaries with transform or opacity need separate layers
+bool Document::can_demote(Element* elem) {
+    return elem->parent != nullptr && !elem->is_repaint_boundary_fixed &&
+           !elem->controls_layer_tree &&
+           elem->layer_tree->get_compose_transform().isIdentity() &&
+           elem->layer_tree->get_compose_opacity() == 1;
+}
+
+// Moves painting of the element from its current boundary to separate layer
+void Document::make_repaint_boundary(Element* elem) {
+    auto boundary = elem->find_closest_repaint_boundary();
+    // Display lists of the ancestors contain painting of the element, that now
+    // goes to the separate layer
+    for (auto it = elem; it != boundary; it = it->parent) {
+        it->display_list = nullptr;
+    }
+    boundary->display_list = nullptr;
+    elem->is_repaint_boundary = true;
+    elem->layer_tree->is_changed = true;
+    HitTester::invalidate(boundary);
+    repaint_boundaries.push(boundary, boundary->depth);
+}
+
+void Document::promote_repaint_boundary(Element* elem) {
+    make_repaint_boundary(elem);
+    elem->repaint_stats = RepaintStats();
+    elem->repaint_stats.window_start = paint_pass;
+    elem->repaint_stats.is_promoted = true;
+
+    last_frame_counters.repaint_boundaries_promoted++;
+    repaint_boundary_stats.promotions++;
+    repaint_boundary_stats.promoted++;
+    repaint_boundary_stats.layer_bytes_added += get_layer_bytes(elem);
+}
+
+void Document::demote_repaint_boundary(Element* elem) {
+    auto was_promoted = elem->repaint_stats.is_promoted;
+    elem->is_repaint_boundary = false;
+    auto boundary = elem->find_closest_repaint_boundary();
+    release_layers(elem->layer_tree->children);
+    elem->layer_tree->set_clip(std::nullopt);
+    elem->hit_test_index = nullptr;
+    for (auto it = elem; it != boundary; it = it->parent) {
+        it->display_list = nullptr;
+    }
+    boundary->display_list = nullptr;
+    elem->repaint_stats = RepaintStats();
+    elem->repaint_stats.window_start = paint_pass;
+    elem->repaint_stats.is_demoted = true;
+    HitTester::invalidate(boundary);
+    repaint_boundaries.push(boundary, boundary->depth);
+
+    last_frame_counters.repaint_boundaries_demoted++;
+    repaint_boundary_stats.demotions++;
+    if (was_promoted) repaint_boundary_stats.promoted--;
+    repaint_boundary_stats.layer_bytes_saved += get_layer_bytes(elem);
+}
+
+// Approximate size of the layer of the element when it is repaint boundary
+int64_t Document::get_layer_bytes(Element* elem) {
+    auto size = elem->size.scale(pixel_ratio);
+    return static_cast<int64_t>(ceil(size.width)) *
+           static_cast<int64_t>(ceil(size.height)) * 4;
+}
+
+float& get_animated_value(LayerTree* tree, AnimatedProperty property) {
+    auto& values = tree->animated;
+    switch (property) {
+        case AnimatedProperty::opacity:
+            return values.opacity;
+        case AnimatedProperty::translate_left:
+            return values.translate_left;
+        case AnimatedProperty::translate_top:
+            return values.translate_top;
+        case AnimatedProperty::scale:
+            return values.scale;
+        case AnimatedProperty::rotation:
+            return values.rotation;
+    }
+    return values.opacity;
+}
+
+int Document::start_animation(
+    std::shared_ptr<Element> elem,
+    AnimatedProperty property,
+    const AnimationOptions& options,
+    AnimationCallback callback) {
+    for (auto& it : animations) {
+        if (it.elem.lock() == elem && it.property == property) {
+            stop_animation(it.id);
+            break;
+        }
+    }
+    if (!elem->is_repaint_boundary) {
+        if (elem->document == this && elem->parent != nullptr) {
+            make_repaint_boundary(elem.get());
+        } else {
+            elem->is_repaint_boundary = true;
+        }
+    }
+    // Animated boundary should not be demoted
+    elem->is_repaint_boundary_fixed = true;
+
+    auto from = std::isnan(options.from)
+                    ? get_animated_value(elem->layer_tree.get(), property)
+                    : options.from;
+    auto id = next_animation_id++;
+    animations.push_back(RunningAnimation{
+        id,                           // id
+        elem,                         // elem
+        property,                     // property
+        Animation(options, from),     // animation
+        std::move(callback),          // callback
+        std::nullopt                  // start_time
+    });
+    request_frame();
+    return id;
+}
+
+void Document::stop_animation(int id) {
+    auto it = std::find_if(
+        animations.begin(), animations.end(),
+        [id](const RunningAnimation& animation) { return animation.id == id; });
+    if (it == animations.end()) return;
+    auto callback = std::move(it->callback);
+    animations.erase(it);
+    if (callback) callback(false /* finished */);
+}
+
+// Updates animated values of the layer trees. Callbacks are called after all
+// animations are updated, because they can start or stop animations.
+void Document::update_animations() {
+    if (animations.empty()) return;
+    auto profiler_scope = ProfilerScope("Document::update_animations");
+    auto now = Clock::now();
+    auto ended = std::vector<std::pair<AnimationCallback, bool>>();
+    auto it = animations.begin();
+    while (it != animations.end()) {
+        auto elem = it->elem.lock();
+        // Animations of the removed elements are stopped
+        if (elem == nullptr || elem->document != this) {
+            ended.emplace_back(std::move(it->callback), false);
+            it = animations.erase(it);
+            continue;
+        }
+        if (it->start_time == std::nullopt) it->start_time = now;
+        auto time = std::chrono::duration<double, std::milli>(
+                        now - it->start_time.value())
+                        .count();
+        auto tree = elem->layer_tree.get();
+        get_animated_value(tree, it->property) = it->animation.value_at(time);
+        tree->is_changed = true;
+        if (it->animation.is_done) {
+            ended.emplace_back(std::move(it->callback), true);
+            it = animations.erase(it);
+        } else {
+            it++;
+        }
+    }
+    if (Profiler::is_enabled()) {
+        Profiler::record_counter("animations_running", animations.size());
+    }
+    if (!animations.empty()) request_frame();
+    for (auto& [callback, finished] : ended) {
+        if (callback) callback(finished);
+    }
+}
+
 Layer* Document::get_layer() {
+    // Icons go below everything that is painted after them
+    flush_icons();
     // If there is no current layer, setup default layer
     Layer* layer;
     if (current_layer == nullptr) {
@@ -264,10 +942,9 @@ void Document::setup_layer(Layer* layer, Element* elem) {
     layer->canvas->scale(pixel_ratio, pixel_ratio);
     auto layer_pos = current_layer_tree->element->abs_position;
     if (current_clip != std::nullopt) {
-        SkPath offset_clip;
-        current_clip.value().offset(
-            -layer_pos.left, -layer_pos.top, &offset_clip);
-        layer->canvas->clipPath(offset_clip, SkClipOp::kIntersect, true);
+        current_clip.value()
+            .offset(-layer_pos.left, -layer_pos.top)
+            .apply(layer->canvas);
     }
     layer->canvas->translate(
         elem->abs_position.left - layer_pos.left,
@@ -275,25 +952,33 @@ void Document::setup_layer(Layer* layer, Element* elem) {
 }
 
 // Creates layer and adds it to the current layer tree, reusing layers from
-// previous repaint if possible.
+// previous repaint or surfaces from the pool if possible.
 Layer* Document::create_layer(Size size) {
-    std::cout << "CREATE LAYER " << size.width << std::endl;
+    flush_icons();
     auto it = layers_pool.begin();
     while (it != layers_pool.end()) {
         auto prev_layer =
             std::get_if<std::shared_ptr<Layer>>(&*it /* lol ok */);
         if (prev_layer != nullptr &&
-            Size::is_equal((*prev_layer)->size, size)) {
+            SurfacePool::fits(prev_layer->get(), size)) {
             break;
         }
         it++;
     }
     std::shared_ptr<Layer> layer = nullptr;
     if (it == layers_pool.end()) {
-        layer = Layer::make_offscreen_layer(gr_context, size);
+        auto misses = surface_pool.stats.misses;
+        layer = surface_pool.acquire(size);
+        if (surface_pool.stats.misses == misses) {
+            last_frame_counters.layers_reused++;
+        } else {
+            last_frame_counters.layers_created++;
+        }
     } else {
+        last_frame_counters.layers_reused++;
         layer = std::get<std::shared_ptr<Layer>>(*it);
         layer->reset();
+        layer->size = SurfacePool::layer_size(size);
         layers_pool.erase(it);
     }
     current_layer_tree->add(layer);
@@ -301,13 +986,122 @@ Layer* Document::create_layer(Size size) {
     return current_layer;
 }
 
-void Document::compose() {
+// Returns surfaces of the layers that were not reused to the pool
+void Document::release_layers(std::vector<LayerTreeNode>& nodes) {
+    for (auto& node : nodes) {
+        if (auto layer = std::get_if<std::shared_ptr<Layer>>(&node)) {
+            surface_pool.release(std::move(*layer));
+        }
+    }
+    nodes.clear();
+}
+
+bool Document::compose() {
+    auto profiler_scope = ProfilerScope("Document::compose");
     need_recompose = false;
+    auto damage = collect_damage();
+
+    damage_rects.clear();
+    composed_pixels = 0;
+    for (auto it = SkRegion::Iterator(damage); !it.done(); it.next()) {
+        auto& rect = it.rect();
+        damage_rects.push_back(rect);
+        composed_pixels += static_cast<int64_t>(rect.width()) * rect.height();
+    }
+    if (damage.isEmpty()) return false;
+
+    screen->canvas->save();
+    screen->canvas->clipRegion(damage);
     screen->clear();
     current_opacity = 1;
-
     paint_layer_tree(root->layer_tree.get());
+    screen->canvas->restore();
     screen->canvas->flush();
+    return true;
+}
+
+SkRegion Document::collect_damage() {
+    auto screen_rect = SkIRect::MakeWH(screen->size.width, screen->size.height);
+    auto damage = SkRegion();
+    composed_trees.clear();
+    collect_layer_tree_damage(
+        root->layer_tree.get(),
+        SkMatrix::I(),                // parent_matrix
+        SkRect::Make(screen_rect),    // parent_clip_bounds
+        1,                            // parent_opacity
+        need_full_compose,            // parent_changed
+        &damage);
+    // Layer trees that are not composed anymore damage their previous area
+    for (auto& it : prev_composed_trees) {
+        if (composed_trees.find(it.first) == composed_trees.end()) {
+            damage.op(it.second.bounds.roundOut(), SkRegion::kUnion_Op);
+        }
+    }
+    std::swap(prev_composed_trees, composed_trees);
+
+    if (need_full_compose || !partial_compose) {
+        if (need_full_compose || !damage.isEmpty()) {
+            damage.setRect(screen_rect);
+        }
+    } else {
+        damage.op(screen_rect, SkRegion::kIntersect_Op);
+    }
+    need_full_compose = false;
+    return damage;
+}
+
+// Calculates bounds of the layer tree on the screen and compares them with
+// the previous frame. It uses same transformations as `paint_layer_tree`.
+void Document::collect_layer_tree_damage(
+    LayerTree* tree,
+    const SkMatrix& parent_matrix,
+    const SkRect& parent_clip_bounds,
+    float parent_opacity,
+    bool parent_changed,
+    SkRegion* damage) {
+    auto matrix = parent_matrix;
+    auto pos = tree->element->abs_position;
+    matrix.preScale(pixel_ratio, pixel_ratio);
+    matrix.preTranslate(pos.left, pos.top);
+    auto transform = tree->get_compose_transform();
+    matrix.preConcat(transform);
+    auto clip_bounds = parent_clip_bounds;
+    auto& clip = tree->get_transformed_clip(transform);
+    if (clip != std::nullopt) {
+        auto tree_clip_bounds = matrix.mapRect(clip.value().get_bounds());
+        if (!clip_bounds.intersect(tree_clip_bounds)) clip_bounds.setEmpty();
+    }
+    matrix.preScale(1 / pixel_ratio, 1 / pixel_ratio);
+    auto opacity = parent_opacity * tree->get_compose_opacity();
+
+    auto bounds = SkRect::MakeEmpty();
+    for (auto& item : tree->children) {
+        if (auto layer = std::get_if<std::shared_ptr<Layer>>(&item)) {
+            bounds.join(matrix.mapRect(
+                SkRect::MakeWH((*layer)->size.width, (*layer)->size.height)));
+        }
+    }
+    if (!bounds.intersect(clip_bounds)) bounds.setEmpty();
+
+    auto is_changed = parent_changed || tree->is_changed;
+    auto prev = prev_composed_trees.find(tree);
+    if (prev == prev_composed_trees.end()) {
+        damage->op(bounds.roundOut(), SkRegion::kUnion_Op);
+    } else if (
+        is_changed || prev->second.bounds != bounds ||
+        prev->second.opacity != opacity) {
+        damage->op(prev->second.bounds.roundOut(), SkRegion::kUnion_Op);
+        damage->op(bounds.roundOut(), SkRegion::kUnion_Op);
+    }
+    composed_trees[tree] = ComposedLayerTree{bounds, opacity};
+    tree->is_changed = false;
+
+    for (auto& item : tree->children) {
+        if (auto child_tree = std::get_if<LayerTree*>(&item)) {
+            collect_layer_tree_damage(
+                *child_tree, matrix, clip_bounds, opacity, is_changed, damage);
+        }
+    }
 }
 
 void Document::paint_layer_tree(LayerTree* tree) {
@@ -315,18 +1109,13 @@ void Document::paint_layer_tree(LayerTree* tree) {
     auto pos = tree->element->abs_position;
     screen->canvas->scale(pixel_ratio, pixel_ratio);
     screen->canvas->translate(pos.left, pos.top);
-    screen->canvas->concat(tree->transform);
-    if (tree->clip != std::nullopt) {
-        // TODO cache/lazy calculate if is expensive
-        SkMatrix inverted_transform;
-        tree->transform.invert(&inverted_transform);
-        SkPath transformed_clip;
-        tree->clip.value().transform(inverted_transform, &transformed_clip);
-        screen->canvas->clipPath(transformed_clip, SkClipOp::kIntersect, true);
-    }
+    auto transform = tree->get_compose_transform();
+    screen->canvas->concat(transform);
+    auto& clip = tree->get_transformed_clip(transform);
+    if (clip != std::nullopt) clip.value().apply(screen->canvas);
     screen->canvas->scale(1/pixel_ratio, 1/pixel_ratio);
     auto prev_opacity = current_opacity;
-    current_opacity *= tree->opacity;
+    current_opacity *= tree->get_compose_opacity();
     for (auto item : tree->children) {
         if (std::holds_alternative<LayerTree*>(item)) {
             auto child_tree = std::get<LayerTree*>(item);
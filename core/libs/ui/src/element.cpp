@@ -8,7 +8,53 @@ Element::Element(bool is_repaint_boundary, bool size_depends_on_parent)
       layer_tree(std::make_shared<LayerTree>(this)){};
 
 void Element::change() {
-    if (document != nullptr) document->change_element(this);
+    if (document == nullptr) {
+        invalidate_intrinsic_size();
+    } else {
+        // Document invalidates intrinsic size while holding its lock, because
+        // it modifies ancestors that can be shared between layout threads
+        document->change_element(this);
+    }
+}
+
+float Element::query_intrinsic_height(float width) {
+    intrinsic_queried = true;
+    auto cached = intrinsic_height_cache.get(width);
+    if (cached != std::nullopt) return cached.value();
+    auto height = get_intrinsic_height(width);
+    intrinsic_height_cache.set(width, height);
+    return height;
+}
+
+float Element::query_intrinsic_width(float height) {
+    intrinsic_queried = true;
+    auto cached = intrinsic_width_cache.get(height);
+    if (cached != std::nullopt) return cached.value();
+    auto width = get_intrinsic_width(height);
+    intrinsic_width_cache.set(height, width);
+    return width;
+}
+
+void Element::invalidate_intrinsic_size() {
+    auto current = this;
+    while (current != nullptr) {
+        if (!current->intrinsic_height_cache.empty() ||
+            !current->intrinsic_width_cache.empty()) {
+            current->intrinsic_height_cache.clear();
+            current->intrinsic_width_cache.clear();
+            // Intrinsic size of this element was used by some of its
+            // ancestors, so their layout should be updated as well.
+            current->is_relayout_boundary = false;
+        }
+        current = current->parent;
+    }
+}
+
+void Element::invalidate_layout() {
+    needs_layout = true;
+    is_changed = true;
+    intrinsic_height_cache.clear();
+    intrinsic_width_cache.clear();
 }
 
 bool Element::hit_test(double left, double top) {
@@ -9,19 +9,18 @@ Size BackgroundElement::layout(BoxConstraints constraints) {
             constraints.max_height /* height */
         };
     }
-    auto child_size = child->layout(constraints);
+    auto child_size = document->layout_element(child.get(), constraints);
     child->size = child_size;
     child->rel_position = Position{0, 0};
     return child_size;
 };
 
 void BackgroundElement::paint_background() {
-    auto layer = document->get_layer();
-    document->setup_layer(layer, this);
+    auto canvas = document->get_canvas(this);
     SkPaint paint;
     paint.setColor(color.to_sk_color());
     SkRect rect{0, 0, size.width, size.height};
-    layer->canvas->drawRect(rect, paint);
+    canvas->drawRect(rect, paint);
 }
 
 void BackgroundElement::paint(bool is_changed) {
@@ -64,9 +64,7 @@ Size BorderElement::layout(BoxConstraints constraints) {
 };
 
 void BorderElement::paint(bool is_changed) {
-    auto layer = document->get_layer();
-    document->setup_layer(layer, this);
-    canvas = layer->canvas;
+    canvas = document->get_canvas(this);
 
     // Paint shadows
     if (shadows.size() > 0) {
@@ -111,40 +109,28 @@ void BorderElement::paint(bool is_changed) {
         radiuses.bottom_left,
         radiuses.top_left);
 
-    // TODO if all *inner* radiuses are square
-    bool need_custom_clip = !radiuses.is_square();
-    if (need_custom_clip) {
-        clip_matrix = SkMatrix();
-        clip_path = SkPath();
-        rotation = 0;
-        // top -> right -> bottom -> left
-        clip_side(
-            borders.left,
-            borders.top,
-            borders.right,
-            radiuses.top_left,
-            radiuses.top_right);
-        clip_side(
-            borders.top,
-            borders.right,
-            borders.bottom,
-            radiuses.top_right,
-            radiuses.bottom_right);
-        clip_side(
-            borders.right,
-            borders.bottom,
-            borders.left,
-            radiuses.bottom_right,
-            radiuses.bottom_left);
-        clip_side(
-            borders.bottom,
-            borders.left,
-            borders.top,
-            radiuses.bottom_left,
-            radiuses.top_left);
+    // Child is clipped by the inner edge of the borders, inner radius of the
+    // corner is reduced by the widths of the adjacent borders
+    if (radiuses.is_square()) {
+        child->clip = std::nullopt;
+    } else {
+        auto inner_radius = [](Radius& radius, BorderSide& horiz_side,
+                               BorderSide& vert_side) {
+            return SkVector::Make(
+                fmax(0, radius.width - vert_side.width),
+                fmax(0, radius.height - horiz_side.width));
+        };
+        auto radii = std::array<SkVector, 4>{
+            inner_radius(radiuses.top_left, borders.top, borders.left),
+            inner_radius(radiuses.top_right, borders.top, borders.right),
+            inner_radius(radiuses.bottom_right, borders.bottom, borders.right),
+            inner_radius(radiuses.bottom_left, borders.bottom, borders.left)};
+        auto rrect = SkRRect();
+        rrect.setRectRadii(
+            SkRect::MakeWH(child->size.width, child->size.height),
+            radii.data());
+        child->clip = Clip::make_rrect(rrect);
     }
-    child->clip =
-        need_custom_clip ? std::make_optional(clip_path) : std::nullopt;
     document->paint_element(child.get());
 };
 
@@ -274,37 +260,4 @@ void BorderElement::paint_side(
     rotation += 90;
 };
 
-void BorderElement::clip_side(
-    BorderSide& prev_side,
-    BorderSide& side,
-    BorderSide& next_side,
-    Radius& left_radius,
-    Radius& right_radius) {
-    auto width = (rotation % 180 == 0 ? size.width : size.height) -
-                 prev_side.width - next_side.width;
-    auto begin = fmax(0, left_radius.width - prev_side.width);
-    auto end = width - fmax(0, right_radius.width - next_side.width);
-    clip_path.lineTo(calc(clip_matrix, begin, 0));
-    clip_path.lineTo(calc(clip_matrix, end, 0));
-    auto inner_radius = right_radius.inner(side.width);
-    if (!inner_radius.is_square()) {
-        auto bounds = SkRect::MakeLTRB(
-            width - 2 * inner_radius.width,  // left
-            0,                               // top
-            width,                           // right
-            2 * inner_radius.height          // height
-        );
-        clip_matrix.mapRect(&bounds);
-        clip_path.arcTo(
-            bounds,         // oval bounds
-            rotation - 90,  // startAngle, 0 is right middle
-            90,             // sweepAngle
-            false           // forceMoveTo
-        );
-    }
-
-    transform_to_next_side(clip_matrix, width);
-    rotation += 90;
-};
-
 }  // namespace aardvark
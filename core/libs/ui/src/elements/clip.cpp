@@ -14,10 +14,8 @@ void ClipElement::paint(bool is_changed) {
     document->paint_element(child.get());
 }
 
-SkPath ClipElement::default_clip(Size size) {
-    SkPath path;
-    path.addRect(0, 0, size.width, size.height);
-    return path;
+Clip ClipElement::default_clip(Size size) {
+    return Clip::make_rect(SkRect::MakeWH(size.width, size.height));
 }
 
 }  // namespace aardvark
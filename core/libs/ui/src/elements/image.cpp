@@ -1,5 +1,11 @@
 #include "elements/image.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "layer.hpp"
+
 namespace aardvark {
 
 std::pair<Position, Size> fit_image(
@@ -52,33 +58,84 @@ std::pair<Position, Size> fit_image(
     return std::make_pair(Position{left, top}, Size{width, height});
 }
 
-void ImageElement::init_image() {
-    data = src->get_data();
-    auto sk_data = SkData::MakeWithoutCopy(data.data(), data.size());
-    image = SkImage::MakeFromEncoded(sk_data);
+Size to_size(SkISize size) {
+    return Size{(float)size.width(), (float)size.height()};
+}
+
+SkISize ImageElement::SizeProps::get_decode_size(
+    SkISize original_size) const {
+    auto fit_size =
+        fit_image(size, to_size(original_size), fit, custom_size).second;
+    return SkISize::Make(
+        std::ceil(fit_size.width * pixel_ratio),
+        std::ceil(fit_size.height * pixel_ratio));
+}
+
+ImageElement::SizeProps ImageElement::get_size_props() {
+    return SizeProps{size, fit, custom_size, document->pixel_ratio};
+}
+
+// Image is taken from the shared cache, or decoded in the background at the
+// size at which it is painted, and shown when it is ready
+void ImageElement::request_image() {
+    is_image_requested = true;
+    if (src == nullptr) {
+        image = DecodedImage();
+        return;
+    }
+    requested_props = get_size_props();
+    auto requested_src = src.get();
+    auto weak_elem = weak_from_this();
+    auto cached = ImageCache::get_image(
+        src,
+        [props = requested_props](SkISize original_size) {
+            return props.get_decode_size(original_size);
+        },
+        document->event_loop,
+        [weak_elem, requested_src](DecodedImage decoded) {
+            auto elem = std::static_pointer_cast<ImageElement>(
+                weak_elem.lock());
+            // Source could be changed while the image was decoded
+            if (elem == nullptr || elem->src.get() != requested_src) return;
+            elem->image = std::move(decoded);
+            elem->change();
+        });
+    if (cached.image != nullptr) image = std::move(cached);
 }
 
 void ImageElement::paint(bool is_changed) {
-    if (image == nullptr) init_image();
+    if (!is_image_requested) {
+        request_image();
+    } else if (image.image != nullptr) {
+        // Image is decoded again only when it is painted bigger
+        auto needed = get_size_props().get_decode_size(image.original_size);
+        auto requested = requested_props.get_decode_size(image.original_size);
+        if (needed.width() > requested.width() ||
+            needed.height() > requested.height()) {
+            request_image();
+        }
+    }
+    if (image.image == nullptr) return;
+    // Decoded image is drawn at the place of the original one
     auto [fit_pos, fit_size] = fit_image(
-        size,                                                 // bounds
-        Size{(float)image->width(), (float)image->height()},  // img_size
-        fit,                                                  // fit
-        custom_size                                           // custom_size
+        size,                          // bounds
+        to_size(image.original_size),  // img_size
+        fit,                           // fit
+        custom_size                    // custom_size
     );
-    auto layer = document->get_layer();
-    document->setup_layer(layer, this);
+    auto rect = SkRect::MakeXYWH(
+        fit_pos.left, fit_pos.top, fit_size.width, fit_size.height);
+    if (use_icon_atlas && document->draw_icon(this, image.image, rect)) {
+        return;
+    }
+    auto canvas = document->get_canvas(this);
     auto paint = SkPaint();
     auto sampling = SkSamplingOptions(SkFilterMode::kLinear, SkMipmapMode::kLinear);
-    layer->canvas->drawImageRect(
-        image,
-        SkRect::MakeXYWH(
-            fit_pos.left, fit_pos.top, fit_size.width, fit_size.height),
-        sampling,
-        &paint);
+    canvas->drawImageRect(image.image, rect, sampling, &paint);
 }
 
 void SvgImageElement::init_svg() {
+    // Parser needs null-terminated string, so the data is copied
     auto data = src->get_data();
     svg = std::unique_ptr<SVGNative::SVGDocument>(
         SVGNative::SVGDocument::CreateSVGDocument(data.c_str(), renderer));
@@ -97,8 +154,59 @@ SVGNative::ColorMap convert_color_map(ColorMap& map) {
     return res;
 }
 
+void SvgImageElement::update_color_map() {
+    if (color_map == converted_color_map) return;
+    converted_color_map = color_map;
+    svg_color_map = convert_color_map(color_map);
+    // Key does not depend on the order of iteration of the map
+    auto entries = std::vector<std::string>();
+    for (auto& [id, color] : color_map) {
+        entries.push_back(
+            id + "=" + std::to_string(color.red) + "," +
+            std::to_string(color.green) + "," + std::to_string(color.blue) +
+            "," + std::to_string(color.alpha));
+    }
+    std::sort(entries.begin(), entries.end());
+    color_map_key.clear();
+    for (auto& entry : entries) color_map_key += entry + ";";
+}
+
+void SvgImageElement::render_svg(SkCanvas* canvas, Size img_size) {
+    renderer->SetSkCanvas(canvas);
+    if (color_map.size() > 0) {
+        svg->Render(svg_color_map, img_size.width, img_size.height);
+    } else {
+        svg->Render(img_size.width, img_size.height);
+    }
+}
+
+// Rasterized image is taken from the image cache, or rendered and added to
+// the cache
+sk_sp<SkImage> SvgImageElement::get_raster(Size img_size, Size fit_size) {
+    auto pixel_ratio = document->pixel_ratio;
+    auto width = (int)std::ceil(fit_size.width * pixel_ratio);
+    auto height = (int)std::ceil(fit_size.height * pixel_ratio);
+    if (width <= 0 || height <= 0) return nullptr;
+    auto variant = "svg:" + std::to_string(width) + "x" +
+                   std::to_string(height) + ":" + color_map_key;
+    if (raster != nullptr && variant == raster_variant) return raster;
+    raster_variant = variant;
+    raster = ImageCache::get_rendered_image(src, variant, [&]() {
+        auto surface = Layer::make_offscreen_surface(
+            nullptr, Size{(float)width, (float)height});
+        if (surface == nullptr) return sk_sp<SkImage>();
+        auto canvas = surface->getCanvas();
+        canvas->clear(SK_ColorTRANSPARENT);
+        canvas->scale(width / img_size.width, height / img_size.height);
+        render_svg(canvas, img_size);
+        return surface->makeImageSnapshot();
+    });
+    return raster;
+}
+
 void SvgImageElement::paint(bool is_changed) {
     if (svg == nullptr) init_svg();
+    update_color_map();
     auto img_size = Size{(float)svg->Width(), (float)svg->Height()};
     auto [fit_pos, fit_size] = fit_image(
         size,        // bounds
@@ -106,24 +214,28 @@ void SvgImageElement::paint(bool is_changed) {
         fit,         // fit
         custom_size  // custom_size
     );
-    auto layer = document->get_layer();
-    document->setup_layer(layer, this);
-    layer->canvas->save();
+    if (raster_cache || use_icon_atlas) {
+        auto image = get_raster(img_size, fit_size);
+        if (image == nullptr) return;
+        auto rect = SkRect::MakeXYWH(
+            fit_pos.left, fit_pos.top, fit_size.width, fit_size.height);
+        if (use_icon_atlas && document->draw_icon(this, image, rect)) return;
+        auto paint = SkPaint();
+        document->get_canvas(this)->drawImageRect(
+            image, rect, SkSamplingOptions(SkFilterMode::kLinear), &paint);
+        return;
+    }
+    auto canvas = document->get_canvas(this);
+    canvas->save();
     if (fit_pos != Position::origin) {
-        layer->canvas->translate(fit_pos.left, fit_pos.top);
+        canvas->translate(fit_pos.left, fit_pos.top);
     }
     if (fit_size != img_size) {
-        layer->canvas->scale(
+        canvas->scale(
             fit_size.width / img_size.width, fit_size.height / img_size.height);
     }
-    renderer->SetSkCanvas(layer->canvas);
-    if (color_map.size() > 0) {
-        auto map = convert_color_map(color_map);
-        svg->Render(map, img_size.width, img_size.height);
-    } else {
-        svg->Render(img_size.width, img_size.height);
-    }
-    layer->canvas->restore();
+    render_svg(canvas, img_size);
+    canvas->restore();
 }
 
 }  // namespace aardvark
@@ -29,7 +29,7 @@ Size OverflowElement::layout(BoxConstraints constraints) {
         constraints.min_height,                     // min_height
         max_height.resolve(constraints.max_height)  // max_height
     };
-    auto child_size = child->layout(child_constraints);
+    auto child_size = document->layout_element(child.get(), child_constraints);
     child->size = child_size;
     child->rel_position = Position{0, 0};
     return child_size;
@@ -1,5 +1,10 @@
 #include "elements/paragraph.hpp"
 
+#include <algorithm>
+#include <iterator>
+
+#include "elements/aligned.hpp"
+
 namespace aardvark {
 
 ParagraphElement::ParagraphElement(
@@ -16,26 +21,180 @@ void ParagraphElement::next_line() {
     remaining_width = total_width;
 }
 
+// Lines can be reused only when the root is a decoration span, because the
+// layout can be resumed from the start of any line by making its remainder.
+std::vector<ParagraphElement::ChildRevision>
+ParagraphElement::get_child_revisions() {
+    auto revisions = std::vector<ChildRevision>();
+    if (dynamic_cast<inline_layout::DecorationSpan*>(root.get()) == nullptr) {
+        return revisions;
+    }
+    root->visit_children(
+        [&revisions](std::shared_ptr<inline_layout::Span>& child) {
+            revisions.emplace_back(child.get(), child->get_tree_revision());
+        });
+    return revisions;
+}
+
+// Makes remainder of the root span starting at the start of the line
+std::shared_ptr<inline_layout::Span> ParagraphElement::make_line_start(
+    const ParagraphLine& line) {
+    auto decoration_span =
+        dynamic_cast<inline_layout::DecorationSpan*>(root.get());
+    auto children =
+        std::vector<std::shared_ptr<inline_layout::Span>>{line.start_span};
+    children.insert(
+        children.end(),
+        decoration_span->children.begin() + line.start_child + 1,
+        decoration_span->children.end());
+    return std::make_shared<inline_layout::DecorationSpan>(
+        children,                             // children
+        decoration_span->decoration.right(),  // decoration
+        inline_layout::SpanBase{root.get(), line.start_child});
+}
+
+void ParagraphElement::set_line_start(
+    ParagraphLine& line, inline_layout::Span* span) {
+    auto decoration_span = dynamic_cast<inline_layout::DecorationSpan*>(span);
+    if (decoration_span == nullptr || decoration_span->children.empty()) {
+        return;
+    }
+    line.start_span = decoration_span->children.front();
+    line.start_length = line.start_span->get_text_length();
+}
+
+// Lines are reused from the previous layout when the width is the same.
+// Lines before the first changed child of the root are kept, and the layout
+// is resumed from the start of the first line that contains changed child.
+// When some new line starts at the same place as the old one after all
+// changed children, the old lines starting from it are moved instead of
+// being laid out again. Elements of the discarded lines are recycled.
 float ParagraphElement::layout_inline(float max_width) {
-    total_width = max_width;
+    last_layout_counters = ParagraphLayoutCounters();
+    auto children = get_child_revisions();
+    auto can_reuse = root == laid_out_root &&
+                     root->own_revision == laid_out_root_revision &&
+                     max_width == laid_out_width && !children.empty() &&
+                     !laid_out_children.empty();
+    auto same_count = children.size() == laid_out_children.size();
+    auto first_changed = 0;
+    auto last_changed = static_cast<int>(children.size()) - 1;
+    if (can_reuse) {
+        auto common = static_cast<int>(
+            std::min(children.size(), laid_out_children.size()));
+        while (first_changed < common &&
+               children[first_changed] == laid_out_children[first_changed]) {
+            first_changed++;
+        }
+        if (same_count) {
+            while (last_changed >= first_changed &&
+                   children[last_changed] == laid_out_children[last_changed]) {
+                last_changed--;
+            }
+        } else {
+            // Paddings of the root are applied to its last child, so line
+            // with the old last child is laid out again
+            first_changed = std::min(
+                first_changed, static_cast<int>(laid_out_children.size()) - 1);
+        }
+    }
+
+    auto old_lines = std::move(lines);
     lines.clear();
-    next_line();
-    layout_span(root);
+    total_width = max_width;
+    auto kept = 0;
+    if (can_reuse) {
+        while (kept + 1 < old_lines.size() &&
+               old_lines[kept + 1].start_child < first_changed &&
+               old_lines[kept + 1].start_span != nullptr) {
+            kept++;
+        }
+    }
+    for (auto i = 0; i < kept; i++) lines.push_back(std::move(old_lines[i]));
+
+    auto span = kept == 0 ? root : make_line_start(old_lines[kept]);
+    auto start_child = kept == 0 ? 0 : old_lines[kept].start_child;
+    auto can_reuse_tail = can_reuse && same_count;
+    auto tail = kept;
+    auto tail_found = false;
+    while (span != nullptr) {
+        next_line();
+        current_line->start_child = start_child;
+        set_line_start(*current_line, span.get());
+        if (can_reuse_tail && start_child > last_changed &&
+            current_line->start_span != nullptr) {
+            auto start_length = current_line->start_length;
+            while (tail < old_lines.size() &&
+                   (old_lines[tail].start_child < start_child ||
+                    (old_lines[tail].start_child == start_child &&
+                     old_lines[tail].start_length > start_length))) {
+                tail++;
+            }
+            if (tail < old_lines.size() &&
+                old_lines[tail].start_child == start_child &&
+                old_lines[tail].start_length == start_length) {
+                lines.pop_back();
+                tail_found = true;
+                break;
+            }
+        }
+        last_layout_counters.lines_laid_out++;
+        auto remainder = layout_span(span);
+        // Remainder of the span is derived from it, offset is the number of
+        // the children that were completely fit
+        if (remainder != nullptr && remainder != span) {
+            start_child += remainder->base_span.prev_offset;
+        }
+        span = remainder;
+    }
+
+    auto recycled = std::vector<std::shared_ptr<Element>>();
+    auto discarded_end = tail_found ? tail : old_lines.size();
+    for (auto i = kept; i < discarded_end; i++) {
+        auto& line_elements = old_lines[i].elements;
+        std::move(
+            line_elements.begin(),
+            line_elements.end(),
+            std::back_inserter(recycled));
+    }
+    auto new_lines_end = lines.size();
+    if (tail_found) {
+        for (auto i = tail; i < old_lines.size(); i++) {
+            lines.push_back(std::move(old_lines[i]));
+        }
+    }
 
     elements.clear();
     auto current_height = 0.0f;
-    for (auto& line : lines) {
-        line.metrics =
-            inline_layout::calc_combined_metrics(line.spans, metrics);
-        inline_layout::render_spans(
-            line.spans,
-            line.metrics,
-            Position{0, current_height},
-            &elements,
-            this);
+    for (auto i = 0; i < lines.size(); i++) {
+        auto& line = lines[i];
+        if (i >= kept && i < new_lines_end) {
+            line.metrics =
+                inline_layout::calc_combined_metrics(line.spans, metrics);
+            line.top = current_height;
+            render_line(line, &recycled);
+        } else {
+            if (line.top != current_height) {
+                // Line from the tail is moved
+                for (auto& elem : line.elements) {
+                    auto aligned = dynamic_cast<AlignedElement*>(elem.get());
+                    aligned->alignment.vert.value += current_height - line.top;
+                    aligned->invalidate_layout();
+                }
+            }
+            last_layout_counters.lines_reused++;
+            last_layout_counters.elements_reused += line.elements.size();
+        }
+        line.top = current_height;
+        elements.insert(
+            elements.end(), line.elements.begin(), line.elements.end());
         current_height += line.metrics.height;
     }
 
+    laid_out_root = root;
+    laid_out_root_revision = root->own_revision;
+    laid_out_children = std::move(children);
+    laid_out_width = max_width;
     return current_height;
 }
 
@@ -50,7 +209,69 @@ Size ParagraphElement::layout(BoxConstraints constraints) {
     return Size{constraints.max_width, height};
 }
 
-void ParagraphElement::layout_span(
+// Text spans of the line are added to its blobs, and other spans are rendered
+// into elements
+void ParagraphElement::render_line(
+    ParagraphLine& line, std::vector<std::shared_ptr<Element>>* recycled) {
+    auto builder = inline_layout::LineTextBuilder();
+    auto left = 0.0f;
+    for (auto& span : line.spans) {
+        render_span(
+            span, line.metrics, Position{left, 0}, line, builder, recycled);
+        left += span->width;
+    }
+    line.blobs = builder.build();
+}
+
+// Offset is the position of the container of the span relative to the line
+void ParagraphElement::render_span(
+    const std::shared_ptr<inline_layout::Span>& span,
+    const inline_layout::LineMetrics& container_metrics,
+    Position offset,
+    ParagraphLine& line,
+    inline_layout::LineTextBuilder& builder,
+    std::vector<std::shared_ptr<Element>>* recycled) {
+    auto top = offset.top + span->vert_align(container_metrics, span->metrics);
+    auto text_span = dynamic_cast<inline_layout::TextSpan*>(span.get());
+    if (text_span != nullptr && text_span->style.decorations.empty()) {
+        builder.add_span(text_span, offset.left, top);
+        last_layout_counters.text_spans_batched++;
+        return;
+    }
+
+    // Decoration span that has nothing to paint only positions its children
+    auto decoration_span =
+        dynamic_cast<inline_layout::DecorationSpan*>(span.get());
+    if (decoration_span != nullptr &&
+        decoration_span->decoration.background == std::nullopt &&
+        decoration_span->decoration.borders == std::nullopt &&
+        decoration_span->decoration.padding == std::nullopt) {
+        auto left = offset.left;
+        for (auto& child : decoration_span->children) {
+            render_span(
+                child, span->metrics, Position{left, top}, line, builder,
+                recycled);
+            left += child->width;
+        }
+        return;
+    }
+
+    auto elements_count = line.elements.size();
+    auto reused = inline_layout::render_spans(
+        {span},
+        container_metrics,
+        Position{offset.left, line.top + offset.top},
+        &line.elements,
+        this,
+        recycled);
+    last_layout_counters.elements_reused += reused;
+    last_layout_counters.elements_rendered +=
+        line.elements.size() - elements_count - reused;
+}
+
+// Lays out span into the current line, returns remainder that should be laid
+// out on the next line
+std::shared_ptr<inline_layout::Span> ParagraphElement::layout_span(
     std::shared_ptr<inline_layout::Span> span_sp) {
     auto constraints = inline_layout::InlineConstraints{
         remaining_width,  // remaining_line_width
@@ -66,13 +287,20 @@ void ParagraphElement::layout_span(
         current_line->spans.push_back(fit_span);
         remaining_width -= result.width;
     }
-    if (result.remainder_span != std::nullopt) {
-        next_line();
-        layout_span(result.remainder_span.value());
-    }
+    return result.remainder_span.value_or(nullptr);
 }
 
+// Text of each line is painted with one draw call per color
 void ParagraphElement::paint(bool is_changed) {
+    auto canvas = document->get_canvas(this);
+    auto paint = SkPaint();
+    paint.setAntiAlias(true);
+    for (auto& line : lines) {
+        for (auto& text_blob : line.blobs) {
+            paint.setColor(text_blob.color);
+            canvas->drawTextBlob(text_blob.blob, 0, line.top, paint);
+        }
+    }
     for (auto& elem : elements) document->paint_element(elem.get());
 }
 
@@ -80,8 +308,30 @@ void ParagraphElement::visit_children(ChildrenVisitor visitor) {
     for (auto& elem : elements) visitor(elem);
 }
 
+// Height is measured without changing the lines, because the layout of the
+// paragraph is skipped when its constraints are not changed after the query
 float ParagraphElement::get_intrinsic_height(float width) {
-    return layout_inline(width);
+    auto height = 0.0f;
+    auto span = root;
+    while (span != nullptr) {
+        auto result = span->layout(inline_layout::InlineConstraints{
+            width,  // remaining_line_width
+            width,  // total_line_width
+            0,      // padding_before
+            0       // padding_after
+        });
+        // Same as the combined metrics of the line in the layout
+        auto ascent = metrics.baseline;
+        auto descent = metrics.height - metrics.baseline;
+        if (result.fit_span != std::nullopt) {
+            ascent = std::max(ascent, result.metrics.baseline);
+            descent = std::max(
+                descent, result.metrics.height - result.metrics.baseline);
+        }
+        height += ascent + descent;
+        span = result.remainder_span.value_or(nullptr);
+    }
+    return height;
 }
 
 float ParagraphElement::get_intrinsic_width(float height) {
@@ -34,26 +34,27 @@ float TextElement::get_intrinsic_height(float width) {
 }
 
 float TextElement::get_intrinsic_width(float height) {
-    return inline_layout::measure_text_width(text, style.to_sk_font());
+    return inline_layout::measure_text_width(
+        text, style.get_cached_font().font);
 }
 
 Size TextElement::layout(BoxConstraints constraints) {
-    // TODO cache (lazy calculation)
-    auto font = style.to_sk_font();
-    auto metrics = inline_layout::LineMetrics::from_sk_font(font);
-    return Size{inline_layout::measure_text_width(text, font), metrics.height};
+    auto& cached = style.get_cached_font();
+    return Size{
+        inline_layout::measure_text_width(text, cached.font),  // width
+        cached.metrics.height                                  // height
+    };
 };
 
 void TextElement::paint(bool is_changed) {
-    auto layer = document->get_layer();
-    document->setup_layer(layer, this);
+    auto canvas = document->get_canvas(this);
 
     auto paint = style.to_sk_paint();
     paint.setAntiAlias(true);
-    auto font = style.to_sk_font();
-    auto metrics =
-        inline_layout::LineMetrics::from_sk_font(font).scale(style.line_height);
-    layer->canvas->drawSimpleText(
+    auto& cached = style.get_cached_font();
+    auto& font = cached.font;
+    auto metrics = cached.metrics.scale(style.line_height);
+    canvas->drawSimpleText(
         text.getBuffer(),        // text
         text.length() * 2,       // byteLength
         SkTextEncoding::kUTF16,  // encoding
@@ -65,7 +66,7 @@ void TextElement::paint(bool is_changed) {
 
     // TODO improve paint order
     for (auto& decoration : style.decorations) {
-        paint_text_decoration(decoration, *layer->canvas, metrics, size.width);
+        paint_text_decoration(decoration, *canvas, metrics, size.width);
     }
 };
 
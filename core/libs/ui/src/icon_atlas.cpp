@@ -0,0 +1,130 @@
+#include "icon_atlas.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace aardvark {
+
+// Transparent gap between the icons, so they do not bleed into each other
+// when sampled with filtering
+const auto ICON_PADDING = 1;
+
+IconAtlasPage::IconAtlasPage(int size) : size(size) {
+    surface = SkSurface::MakeRasterN32Premul(size, size);
+    surface->getCanvas()->clear(SK_ColorTRANSPARENT);
+}
+
+std::optional<SkIRect> IconAtlasPage::allocate(SkISize icon_size) {
+    auto width = icon_size.width() + ICON_PADDING;
+    auto height = icon_size.height() + ICON_PADDING;
+    // Lowest shelf that fits the icon wastes less space
+    Shelf* best = nullptr;
+    for (auto& shelf : shelves) {
+        if (shelf.height < height || shelf.used_width + width > size) continue;
+        if (best == nullptr || shelf.height < best->height) best = &shelf;
+    }
+    if (best == nullptr) {
+        auto top = shelves.empty()
+                       ? 0
+                       : shelves.back().top + shelves.back().height;
+        if (top + height > size || width > size) return std::nullopt;
+        shelves.push_back(Shelf{top, height, 0});
+        best = &shelves.back();
+    }
+    auto rect = SkIRect::MakeXYWH(
+        best->used_width, best->top, icon_size.width(), icon_size.height());
+    best->used_width += width;
+    return rect;
+}
+
+SkCanvas* IconAtlasPage::get_canvas() {
+    image = nullptr;
+    return surface->getCanvas();
+}
+
+sk_sp<SkImage> IconAtlasPage::get_image() {
+    if (image == nullptr) image = surface->makeImageSnapshot();
+    return image;
+}
+
+std::optional<AtlasIcon> IconAtlas::get_icon(
+    const sk_sp<SkImage>& image, int frame) {
+    auto it = entries.find(image->uniqueID());
+    if (it != entries.end()) {
+        it->second.last_used = frame;
+        return AtlasIcon{it->second.page, SkRect::Make(it->second.rect)};
+    }
+    if (image->width() > MAX_ICON_SIZE || image->height() > MAX_ICON_SIZE) {
+        return std::nullopt;
+    }
+    auto entry = allocate(image->dimensions());
+    if (entry == std::nullopt && last_repack_frame != frame) {
+        repack(frame);
+        entry = allocate(image->dimensions());
+    }
+    if (entry == std::nullopt) return std::nullopt;
+    auto paint = SkPaint();
+    paint.setBlendMode(SkBlendMode::kSrc);
+    entry->page->get_canvas()->drawImage(
+        image, entry->rect.left(), entry->rect.top(), SkSamplingOptions(),
+        &paint);
+    entry->last_used = frame;
+    entries[image->uniqueID()] = entry.value();
+    stats.icons_added++;
+    return AtlasIcon{entry->page, SkRect::Make(entry->rect)};
+}
+
+std::optional<IconAtlas::Entry> IconAtlas::allocate(SkISize size) {
+    for (auto& page : pages) {
+        auto rect = page->allocate(size);
+        if (rect != std::nullopt) return Entry{page, rect.value(), 0};
+    }
+    if ((int)pages.size() >= max_pages) return std::nullopt;
+    auto page = std::make_shared<IconAtlasPage>(page_size);
+    pages.push_back(page);
+    auto rect = page->allocate(size);
+    if (rect == std::nullopt) return std::nullopt;
+    return Entry{page, rect.value(), 0};
+}
+
+// Icons that were used in the current frame are copied into the new pages,
+// other icons are evicted. Old pages are kept alive by the icons that were
+// returned before repacking, until they are drawn.
+void IconAtlas::repack(int frame) {
+    last_repack_frame = frame;
+    stats.repacks++;
+    auto used = std::vector<std::pair<uint32_t, Entry>>();
+    for (auto& [id, entry] : entries) {
+        if (entry.last_used == frame) {
+            used.emplace_back(id, entry);
+        } else {
+            stats.evictions++;
+        }
+    }
+    // Taller icons are packed first, so shelves are filled more evenly
+    std::sort(used.begin(), used.end(), [](auto& a, auto& b) {
+        return a.second.rect.height() > b.second.rect.height();
+    });
+    entries.clear();
+    pages.clear();
+    auto paint = SkPaint();
+    paint.setBlendMode(SkBlendMode::kSrc);
+    for (auto& [id, old_entry] : used) {
+        auto entry = allocate(old_entry.rect.size());
+        if (entry == std::nullopt) {
+            stats.evictions++;
+            continue;
+        }
+        entry->page->get_canvas()->drawImageRect(
+            old_entry.page->get_image(),
+            SkRect::Make(old_entry.rect),
+            SkRect::Make(entry->rect),
+            SkSamplingOptions(),
+            &paint,
+            SkCanvas::kStrict_SrcRectConstraint);
+        entry->last_used = frame;
+        entries[id] = entry.value();
+    }
+}
+
+}  // namespace aardvark
@@ -0,0 +1,314 @@
+#include "image_cache.hpp"
+
+#include <algorithm>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "SkBitmap.h"
+#include "SkCodec.h"
+#include "SkData.h"
+#include "utils/log.hpp"
+
+namespace aardvark {
+
+struct ImageCacheEntry {
+    DecodedImage decoded;
+    int64_t bytes;
+    // Position in the list of keys from most to least recently used
+    std::list<std::string>::iterator lru_it;
+};
+
+struct ImageWaiter {
+    EventLoop* event_loop;
+    ImageCallback callback;
+    ImageSizer sizer;
+};
+
+struct ImageCacheState {
+    std::mutex mutex;
+    std::unordered_map<std::string, ImageCacheEntry> entries;
+    std::list<std::string> lru;
+    // Callbacks of the requests of the images that are being decoded
+    std::unordered_map<std::string, std::vector<ImageWaiter>> decoding;
+    // Sources that have no key are identified by the address, they are kept
+    // alive while they are cached, so the address can not be reused
+    std::unordered_map<std::string, std::shared_ptr<DataSource>> sources;
+    int64_t budget = ImageCache::DEFAULT_BUDGET;
+    ImageCacheStats stats;
+};
+
+ImageCacheState& get_image_cache_state() {
+    static auto state = ImageCacheState();
+    return state;
+}
+
+boost::asio::thread_pool& get_decode_pool() {
+    static auto pool = boost::asio::thread_pool(
+        std::clamp(std::thread::hardware_concurrency() / 2, 1u, 4u));
+    return pool;
+}
+
+std::string get_source_key(const std::shared_ptr<DataSource>& src) {
+    auto key = src->get_key();
+    if (!key.empty()) return key;
+    return "address:" + std::to_string(reinterpret_cast<uintptr_t>(src.get()));
+}
+
+// Size is limited by the original size, images are never upscaled
+SkISize get_target_size(const ImageSizer& sizer, SkISize original_size) {
+    if (sizer == nullptr) return original_size;
+    auto size = sizer(original_size);
+    return SkISize::Make(
+        std::clamp(size.width(), 1, original_size.width()),
+        std::clamp(size.height(), 1, original_size.height()));
+}
+
+bool covers_size(const sk_sp<SkImage>& image, SkISize size) {
+    return image->width() >= size.width() && image->height() >= size.height();
+}
+
+// Decodes pixels right away, because encoded images are decoded lazily when
+// they are drawn. Codec decodes at the closest size that it supports, and
+// the result is resized to the exact size.
+DecodedImage decode_image(DataSource* src, const ImageSizer& sizer) {
+    auto codec = SkCodec::MakeFromData(src->get_sk_data());
+    if (codec == nullptr) {
+        Log::error("[ImageCache] Failed to decode image");
+        return DecodedImage();
+    }
+    auto original_size = codec->dimensions();
+    auto target_size = get_target_size(sizer, original_size);
+    auto scale = std::max(
+        static_cast<float>(target_size.width()) / original_size.width(),
+        static_cast<float>(target_size.height()) / original_size.height());
+    auto codec_size = codec->getScaledDimensions(scale);
+    auto alpha_type = codec->getInfo().alphaType() == kOpaque_SkAlphaType
+                          ? kOpaque_SkAlphaType
+                          : kPremul_SkAlphaType;
+    auto info = codec->getInfo()
+                    .makeDimensions(codec_size)
+                    .makeColorType(kN32_SkColorType)
+                    .makeAlphaType(alpha_type);
+    auto bitmap = SkBitmap();
+    bitmap.allocPixels(info);
+    auto result = codec->getPixels(info, bitmap.getPixels(), bitmap.rowBytes());
+    if (result != SkCodec::kSuccess && result != SkCodec::kIncompleteInput) {
+        Log::error(
+            "[ImageCache] Failed to decode image: {}",
+            SkCodec::ResultToString(result));
+        return DecodedImage();
+    }
+    if (codec_size != target_size) {
+        auto resized = SkBitmap();
+        resized.allocPixels(info.makeDimensions(target_size));
+        bitmap.pixmap().scalePixels(
+            resized.pixmap(),
+            SkSamplingOptions(SkFilterMode::kLinear, SkMipmapMode::kLinear));
+        bitmap = resized;
+    }
+    bitmap.setImmutable();
+    return DecodedImage{bitmap.asImage(), original_size};
+}
+
+int64_t get_image_bytes(const sk_sp<SkImage>& image) {
+    return static_cast<int64_t>(image->imageInfo().computeMinByteSize());
+}
+
+// Should be called while holding the lock
+void evict_images(ImageCacheState& state, const std::string* keep_key) {
+    auto it = state.lru.end();
+    while (state.stats.bytes > state.budget && it != state.lru.begin()) {
+        it--;
+        if (keep_key != nullptr && *it == *keep_key) continue;
+        auto entry = state.entries.find(*it);
+        state.stats.bytes -= entry->second.bytes;
+        state.stats.evictions++;
+        state.entries.erase(entry);
+        state.sources.erase(*it);
+        it = state.lru.erase(it);
+    }
+}
+
+// Replaces smaller image of the same source. Returns image that is cached
+// after adding. Should be called while holding the lock.
+DecodedImage add_image(
+    ImageCacheState& state,
+    const std::string& key,
+    const std::shared_ptr<DataSource>& src,
+    DecodedImage decoded) {
+    auto existing = state.entries.find(key);
+    if (existing != state.entries.end()) {
+        auto& cached = existing->second.decoded;
+        if (covers_size(cached.image, decoded.image->dimensions())) {
+            return cached;
+        }
+        state.stats.bytes -= existing->second.bytes;
+        state.lru.erase(existing->second.lru_it);
+        state.entries.erase(existing);
+    }
+    state.lru.push_front(key);
+    auto bytes = get_image_bytes(decoded.image);
+    state.entries[key] = ImageCacheEntry{decoded, bytes, state.lru.begin()};
+    if (src->get_key().empty()) state.sources[key] = src;
+    state.stats.bytes += bytes;
+    evict_images(state, &key);
+    return decoded;
+}
+
+// Sizer of the image that is needed by all of the waiters
+ImageSizer get_covering_sizer(const std::vector<ImageWaiter>& waiters) {
+    auto sizers = std::vector<ImageSizer>();
+    for (auto& waiter : waiters) sizers.push_back(waiter.sizer);
+    return [sizers](SkISize original_size) {
+        auto width = 0;
+        auto height = 0;
+        for (auto& sizer : sizers) {
+            auto size = get_target_size(sizer, original_size);
+            width = std::max(width, size.width());
+            height = std::max(height, size.height());
+        }
+        return SkISize::Make(width, height);
+    };
+}
+
+// Requests that joined the decoding can need bigger image than the one that
+// is being decoded, then the image is decoded again for them.
+void decode_in_background(
+    std::shared_ptr<DataSource> src, std::string key, ImageSizer sizer) {
+    boost::asio::post(get_decode_pool(), [src, key, sizer]() {
+        auto& state = get_image_cache_state();
+        auto decoded = decode_image(src.get(), sizer);
+        auto ready = std::vector<ImageWaiter>();
+        auto next_sizer = ImageSizer();
+        {
+            auto lock = std::lock_guard<std::mutex>(state.mutex);
+            if (decoded.image != nullptr) {
+                decoded = add_image(state, key, src, decoded);
+            }
+            auto& waiters = state.decoding[key];
+            auto pending = std::vector<ImageWaiter>();
+            for (auto& waiter : waiters) {
+                auto is_ready =
+                    decoded.image == nullptr ||
+                    covers_size(
+                        decoded.image,
+                        get_target_size(waiter.sizer, decoded.original_size));
+                (is_ready ? ready : pending).push_back(std::move(waiter));
+            }
+            if (pending.empty()) {
+                state.decoding.erase(key);
+            } else {
+                next_sizer = get_covering_sizer(pending);
+                waiters = std::move(pending);
+                state.stats.decodes++;
+            }
+        }
+        for (auto& waiter : ready) {
+            waiter.event_loop->post_callback(
+                [callback = std::move(waiter.callback), decoded]() {
+                    callback(decoded);
+                });
+        }
+        if (next_sizer != nullptr) decode_in_background(src, key, next_sizer);
+    });
+}
+
+DecodedImage ImageCache::get_image(
+    const std::shared_ptr<DataSource>& src,
+    const ImageSizer& sizer,
+    EventLoop* event_loop,
+    ImageCallback callback) {
+    auto& state = get_image_cache_state();
+    auto key = get_source_key(src);
+    auto cached = DecodedImage();
+    {
+        auto lock = std::lock_guard<std::mutex>(state.mutex);
+        auto it = state.entries.find(key);
+        if (it != state.entries.end()) {
+            cached = it->second.decoded;
+            state.lru.splice(state.lru.begin(), state.lru, it->second.lru_it);
+            auto size = get_target_size(sizer, cached.original_size);
+            if (covers_size(cached.image, size)) {
+                state.stats.hits++;
+                return cached;
+            }
+        }
+        state.stats.misses++;
+        if (event_loop != nullptr) {
+            auto waiters = state.decoding.find(key);
+            if (waiters != state.decoding.end()) {
+                waiters->second.push_back(
+                    ImageWaiter{event_loop, std::move(callback), sizer});
+                return cached;
+            }
+            state.decoding[key].push_back(
+                ImageWaiter{event_loop, std::move(callback), sizer});
+        }
+        state.stats.decodes++;
+    }
+
+    if (event_loop == nullptr) {
+        auto decoded = decode_image(src.get(), sizer);
+        if (decoded.image == nullptr) return cached;
+        auto lock = std::lock_guard<std::mutex>(state.mutex);
+        return add_image(state, key, src, decoded);
+    }
+
+    // Smaller image of the source is returned until decoding is finished
+    decode_in_background(src, key, sizer);
+    return cached;
+}
+
+sk_sp<SkImage> ImageCache::get_rendered_image(
+    const std::shared_ptr<DataSource>& src,
+    const std::string& variant,
+    const ImageRenderer& render) {
+    auto& state = get_image_cache_state();
+    auto key = get_source_key(src) + "#" + variant;
+    {
+        auto lock = std::lock_guard<std::mutex>(state.mutex);
+        auto it = state.entries.find(key);
+        if (it != state.entries.end()) {
+            state.lru.splice(state.lru.begin(), state.lru, it->second.lru_it);
+            state.stats.hits++;
+            return it->second.decoded.image;
+        }
+        state.stats.misses++;
+        state.stats.renders++;
+    }
+    // Lock is not held while rendering, so the image can be rendered by
+    // several threads at once, and only one of the images is kept
+    auto image = render();
+    if (image == nullptr) return nullptr;
+    auto lock = std::lock_guard<std::mutex>(state.mutex);
+    auto rendered = DecodedImage{image, image->dimensions()};
+    return add_image(state, key, src, rendered).image;
+}
+
+void ImageCache::set_budget(int64_t bytes) {
+    auto& state = get_image_cache_state();
+    auto lock = std::lock_guard<std::mutex>(state.mutex);
+    state.budget = bytes;
+    evict_images(state, nullptr);
+}
+
+ImageCacheStats ImageCache::get_stats() {
+    auto& state = get_image_cache_state();
+    auto lock = std::lock_guard<std::mutex>(state.mutex);
+    return state.stats;
+}
+
+void ImageCache::clear() {
+    auto& state = get_image_cache_state();
+    auto lock = std::lock_guard<std::mutex>(state.mutex);
+    state.entries.clear();
+    state.lru.clear();
+    state.sources.clear();
+    state.stats = ImageCacheStats();
+}
+
+}  // namespace aardvark
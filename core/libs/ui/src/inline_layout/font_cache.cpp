@@ -0,0 +1,152 @@
+#include "inline_layout/font_cache.hpp"
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "SkFontMgr.h"
+
+namespace aardvark::inline_layout {
+
+struct FontKey {
+    std::string family;
+    int weight;
+    int slant;
+    float size;
+
+    bool operator==(const FontKey& other) const {
+        return family == other.family && weight == other.weight &&
+               slant == other.slant && size == other.size;
+    }
+};
+
+struct FontKeyHash {
+    size_t operator()(const FontKey& key) const {
+        auto hash = std::hash<std::string>()(key.family);
+        hash = hash * 31 + std::hash<int>()(key.weight);
+        hash = hash * 31 + std::hash<int>()(key.slant);
+        hash = hash * 31 + std::hash<float>()(key.size);
+        return hash;
+    }
+};
+
+// Most lookups are hits, so they take shared lock and only misses take
+// exclusive lock. Elements of unordered map keep their addresses when the
+// map grows.
+struct FontCacheState {
+    std::shared_mutex mutex;
+    std::unordered_map<FontKey, sk_sp<SkTypeface>, FontKeyHash> typefaces;
+    std::unordered_map<FontKey, CachedFont, FontKeyHash> fonts;
+    std::atomic<int64_t> hits{0};
+    std::atomic<int64_t> misses{0};
+    std::atomic<int64_t> typefaces_loaded{0};
+};
+
+FontCacheState& get_state() {
+    static FontCacheState state;
+    return state;
+}
+
+std::vector<std::string> split_families(const std::string& family) {
+    auto families = std::vector<std::string>();
+    size_t start = 0;
+    while (start <= family.size()) {
+        auto end = family.find(',', start);
+        if (end == std::string::npos) end = family.size();
+        auto name = family.substr(start, end - start);
+        auto first = name.find_first_not_of(" \t\"'");
+        auto last = name.find_last_not_of(" \t\"'");
+        if (first != std::string::npos) {
+            families.push_back(name.substr(first, last - first + 1));
+        }
+        start = end + 1;
+    }
+    return families;
+}
+
+// Tries requested families, then the default family, and then the default
+// typeface of the system
+sk_sp<SkTypeface> load_typeface(const std::string& family, SkFontStyle style) {
+    auto font_mgr = SkFontMgr::RefDefault();
+    auto families = split_families(family);
+    families.push_back(FontCache::DEFAULT_FAMILY);
+    for (auto& name : families) {
+        auto typeface = sk_sp<SkTypeface>(
+            font_mgr->matchFamilyStyle(name.c_str(), style));
+        if (typeface != nullptr) return typeface;
+    }
+    return font_mgr->legacyMakeTypeface(nullptr, style);
+}
+
+sk_sp<SkTypeface> get_typeface_locked(
+    FontCacheState& state, const FontKey& key, SkFontStyle style) {
+    auto it = state.typefaces.find(key);
+    if (it != state.typefaces.end()) return it->second;
+    state.typefaces_loaded++;
+    auto typeface = load_typeface(key.family, style);
+    state.typefaces.emplace(key, typeface);
+    return typeface;
+}
+
+const CachedFont& FontCache::get_font(
+    const std::string& family, SkFontStyle style, float size) {
+    auto& state = get_state();
+    auto key = FontKey{family, style.weight(), style.slant(), size};
+    {
+        auto lock = std::shared_lock(state.mutex);
+        auto it = state.fonts.find(key);
+        if (it != state.fonts.end()) {
+            state.hits++;
+            return it->second;
+        }
+    }
+    auto lock = std::unique_lock(state.mutex);
+    // Font could be added by another thread while the lock was released
+    auto it = state.fonts.find(key);
+    if (it != state.fonts.end()) {
+        state.hits++;
+        return it->second;
+    }
+    state.misses++;
+    auto typeface_key = FontKey{family, style.weight(), style.slant(), 0};
+    auto font = SkFont(get_typeface_locked(state, typeface_key, style), size);
+    auto metrics = LineMetrics::from_sk_font(font);
+    return state.fonts.emplace(key, CachedFont{font, metrics}).first->second;
+}
+
+sk_sp<SkTypeface> FontCache::get_typeface(
+    const std::string& family, SkFontStyle style) {
+    auto& state = get_state();
+    auto key = FontKey{family, style.weight(), style.slant(), 0};
+    {
+        auto lock = std::shared_lock(state.mutex);
+        auto it = state.typefaces.find(key);
+        if (it != state.typefaces.end()) return it->second;
+    }
+    auto lock = std::unique_lock(state.mutex);
+    return get_typeface_locked(state, key, style);
+}
+
+FontCacheStats FontCache::get_stats() {
+    auto& state = get_state();
+    return FontCacheStats{
+        state.hits.load(),             // hits
+        state.misses.load(),           // misses
+        state.typefaces_loaded.load()  // typefaces_loaded
+    };
+}
+
+void FontCache::clear() {
+    auto& state = get_state();
+    auto lock = std::unique_lock(state.mutex);
+    state.fonts.clear();
+    state.typefaces.clear();
+    state.hits = 0;
+    state.misses = 0;
+    state.typefaces_loaded = 0;
+}
+
+}  // namespace aardvark::inline_layout
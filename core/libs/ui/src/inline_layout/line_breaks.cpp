@@ -0,0 +1,86 @@
+#include "inline_layout/line_breaks.hpp"
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "utils/log.hpp"
+
+namespace aardvark::inline_layout {
+
+struct LocaleIterators {
+    std::unique_ptr<BreakIterator> prototype;
+    // Iterators that are not used at the moment
+    std::vector<std::unique_ptr<BreakIterator>> free;
+};
+
+struct LineBreaksState {
+    std::mutex mutex;
+    std::unordered_map<std::string, LocaleIterators> locales;
+    int created_iterators = 0;
+};
+
+LineBreaksState& get_line_breaks_state() {
+    static LineBreaksState state;
+    return state;
+}
+
+std::unique_ptr<BreakIterator> acquire_iterator(const Locale& locale) {
+    auto& state = get_line_breaks_state();
+    auto lock = std::lock_guard(state.mutex);
+    auto& iterators = state.locales[locale.getName()];
+    if (!iterators.free.empty()) {
+        auto iterator = std::move(iterators.free.back());
+        iterators.free.pop_back();
+        return iterator;
+    }
+    if (iterators.prototype == nullptr) {
+        auto status = U_ZERO_ERROR;
+        auto prototype = std::unique_ptr<BreakIterator>(
+            BreakIterator::createLineInstance(locale, status));
+        if (U_FAILURE(status)) {
+            Log::error(
+                "[LineBreaks] Cannot create line break iterator: {}",
+                u_errorName(status));
+            return nullptr;
+        }
+        iterators.prototype = std::move(prototype);
+        state.created_iterators++;
+    }
+    state.created_iterators++;
+    return std::unique_ptr<BreakIterator>(iterators.prototype->clone());
+}
+
+void release_iterator(
+    const Locale& locale, std::unique_ptr<BreakIterator> iterator) {
+    auto& state = get_line_breaks_state();
+    auto lock = std::lock_guard(state.mutex);
+    state.locales[locale.getName()].free.push_back(std::move(iterator));
+}
+
+std::vector<int> LineBreaks::find(
+    const UnicodeString& text, const Locale& locale) {
+    auto iterator = acquire_iterator(locale);
+    if (iterator == nullptr) return std::vector<int>{0, text.length()};
+    auto breaks = std::vector<int>();
+    iterator->setText(text);
+    for (auto pos = iterator->first(); pos != BreakIterator::DONE;
+         pos = iterator->next()) {
+        breaks.push_back(pos);
+    }
+    // Iterator keeps reference to the text, it should not be kept after the
+    // iterator is returned to the pool
+    static const auto empty_text = UnicodeString();
+    iterator->setText(empty_text);
+    release_iterator(locale, std::move(iterator));
+    return breaks;
+}
+
+int LineBreaks::get_created_iterators() {
+    auto& state = get_line_breaks_state();
+    auto lock = std::lock_guard(state.mutex);
+    return state.created_iterators;
+}
+
+}  // namespace aardvark::inline_layout
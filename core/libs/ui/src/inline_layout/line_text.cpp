@@ -0,0 +1,46 @@
+#include "inline_layout/line_text.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+namespace aardvark::inline_layout {
+
+void LineTextBuilder::add_span(TextSpan* span, float left, float top) {
+    auto length = span->text.length();
+    if (length == 0) return;
+    auto& shaped = span->get_shaped_text();
+    auto offset = span->get_shaped_offset();
+    auto first = shaped.unit_glyphs[offset];
+    auto count = shaped.unit_glyphs[offset + length] - first;
+    if (count == 0) return;
+
+    auto color = span->style.color.to_sk_color();
+    auto it = std::find_if(
+        builders.begin(), builders.end(),
+        [color](auto& item) { return item.first == color; });
+    if (it == builders.end()) {
+        builders.emplace_back(color, std::make_unique<SkTextBlobBuilder>());
+        it = std::prev(builders.end());
+    }
+
+    // Same baseline as the text element would have
+    auto metrics = span->style.get_metrics().scale(span->style.line_height);
+    auto& run = it->second->allocRunPosH(
+        shaped.font, count, top + metrics.baseline);
+    std::copy_n(shaped.glyphs.begin() + first, count, run.glyphs);
+    auto start = shaped.offsets[first];
+    for (auto i = 0; i < count; i++) {
+        run.pos[i] = left + shaped.offsets[first + i] - start;
+    }
+}
+
+std::vector<LineTextBlob> LineTextBuilder::build() {
+    auto blobs = std::vector<LineTextBlob>();
+    for (auto& [color, builder] : builders) {
+        blobs.push_back(LineTextBlob{color, builder->make()});
+    }
+    builders.clear();
+    return blobs;
+}
+
+}  // namespace aardvark::inline_layout
@@ -0,0 +1,91 @@
+#include "inline_layout/shaped_text.hpp"
+
+#include <unicode/utf16.h>
+
+#include <algorithm>
+
+namespace aardvark::inline_layout {
+
+ShapedText::ShapedText(const UnicodeString& text, const SkFont& font)
+    : font(font), length(text.length()) {
+    unit_glyphs.resize(length + 1);
+    glyph_units.reserve(length + 1);
+    // SkFont maps each code point to a single glyph
+    auto buffer = text.getBuffer();
+    auto pos = 0;
+    while (pos < length) {
+        auto glyph = static_cast<int>(glyph_units.size());
+        glyph_units.push_back(pos);
+        auto start = pos;
+        UChar32 c;
+        U16_NEXT(buffer, pos, length, c);
+        for (auto i = start; i < pos; i++) unit_glyphs[i] = glyph;
+    }
+    auto glyph_count = static_cast<int>(glyph_units.size());
+    unit_glyphs[length] = glyph_count;
+    glyph_units.push_back(length);
+
+    glyphs.resize(glyph_count);
+    if (glyph_count > 0) {
+        font.textToGlyphs(
+            buffer,                  // text
+            length * 2,              // byteLength
+            SkTextEncoding::kUTF16,  // encoding
+            glyphs.data(),           // glyphs
+            glyph_count              // maxGlyphCount
+        );
+    }
+    auto widths = std::vector<float>(glyph_count);
+    font.getWidths(glyphs.data(), glyph_count, widths.data());
+    offsets.resize(glyph_count + 1);
+    offsets[0] = 0;
+    for (auto i = 0; i < glyph_count; i++) {
+        offsets[i + 1] = offsets[i] + widths[i];
+    }
+}
+
+float ShapedText::get_width(int start, int end) const {
+    return offsets[unit_glyphs[end]] - offsets[unit_glyphs[start]];
+}
+
+int ShapedText::fit(int start, int end, float max_width, float* width) const {
+    auto first = unit_glyphs[start];
+    auto last = unit_glyphs[end];
+    auto begin = offsets.begin() + first;
+    // First glyph boundary that is further than the max width
+    auto it = std::upper_bound(
+        begin + 1, offsets.begin() + last + 1, offsets[first] + max_width);
+    auto fit_glyph = static_cast<int>(it - offsets.begin()) - 1;
+    *width = offsets[fit_glyph] - offsets[first];
+    return glyph_units[fit_glyph];
+}
+
+int ShapedText::find_position(int start, int end, float distance) const {
+    auto first = unit_glyphs[start];
+    auto last = unit_glyphs[end];
+    auto target = offsets[first] + distance;
+    // Glyph is before the position when its middle is before the distance
+    auto lo = first;
+    auto hi = last;
+    while (lo < hi) {
+        auto mid = (lo + hi) / 2;
+        if ((offsets[mid] + offsets[mid + 1]) / 2 <= target) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return glyph_units[lo];
+}
+
+int ShapedText::prev_position(int pos) const {
+    auto glyph = unit_glyphs[pos];
+    return glyph == 0 ? 0 : glyph_units[glyph - 1];
+}
+
+int ShapedText::next_position(int pos) const {
+    auto glyph = unit_glyphs[pos];
+    return glyph == get_glyph_count() ? length : glyph_units[glyph + 1];
+}
+
+}  // namespace aardvark::inline_layout
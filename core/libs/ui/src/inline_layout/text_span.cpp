@@ -1,6 +1,6 @@
 #include "inline_layout/text_span.hpp"
 
-#include <iostream>
+#include <algorithm>
 
 namespace aardvark::inline_layout {
 
@@ -17,30 +17,19 @@ TextSpan::TextSpan(
 };
 
 void TextSpan::init() {
-    if (this->base_span.span == nullptr) {
-        // Create linebreaker
-        UErrorCode status = U_ZERO_ERROR;
-        linebreaker =
-            BreakIterator::createLineInstance(Locale::getUS(), status);
-        if (U_FAILURE(status)) {
-            std::cout << "Failed to create sentence break iterator. Status = "
-                      << u_errorName(status) << std::endl;
-            exit(1);
-        }
-    } else {
-        // Reuse linebreaker from the base span
-        linebreaker =
-            dynamic_cast<TextSpan*>(this->base_span.span)->linebreaker;
+    if (this->base_span.span != nullptr) {
+        // Reuse shaped text and line breaks from the base span
+        auto base = dynamic_cast<TextSpan*>(this->base_span.span);
+        shaped = base->shaped;
+        shaped_offset = base->shaped_offset + this->base_span.prev_offset;
+        breaks = base->breaks;
+        breaks_offset = base->breaks_offset + this->base_span.prev_offset;
     }
 }
 
-TextSpan::~TextSpan() {
-    if (base_span.span == this) delete linebreaker;
-};
-
 InlineLayoutResult TextSpan::fit(float measured_width) {
     return InlineLayoutResult::fit(
-        measured_width, LineMetrics::from_sk_font(font), shared_from_this());
+        measured_width, style.get_metrics(), shared_from_this());
 };
 
 InlineLayoutResult TextSpan::split(int fit_chars, float fit_width) {
@@ -51,57 +40,92 @@ InlineLayoutResult TextSpan::split(int fit_chars, float fit_width) {
     auto remainder_span = std::make_shared<TextSpan>(
         remainder_text, style, linebreak, SpanBase{this, fit_chars});
     return InlineLayoutResult::split(
-        fit_width, LineMetrics::from_sk_font(font), fit_span, remainder_span);
+        fit_width, style.get_metrics(), fit_span, remainder_span);
 }
 
 InlineLayoutResult TextSpan::wrap() {
     return InlineLayoutResult::wrap(shared_from_this());
 }
 
+const ShapedText& TextSpan::get_shaped_text() {
+    auto& font = style.get_cached_font().font;
+    auto length = text.length();
+    auto is_valid = shaped != nullptr && shaped->font == font &&
+                    (base_span.span == nullptr
+                         ? shaped->length == length
+                         : shaped_offset + length <= shaped->length);
+    if (!is_valid) {
+        shaped = std::make_shared<ShapedText>(text, font);
+        shaped_offset = 0;
+    }
+    return *shaped;
+}
+
+const std::vector<int>& TextSpan::get_line_breaks() {
+    auto length = text.length();
+    auto is_valid = breaks != nullptr &&
+                    (base_span.span == nullptr
+                         ? breaks->back() == length
+                         : breaks_offset + length <= breaks->back());
+    if (!is_valid) {
+        breaks = std::make_shared<std::vector<int>>(LineBreaks::find(text));
+        breaks_offset = 0;
+    }
+    return *breaks;
+}
+
+// Width of the text of the span between code units
+float TextSpan::get_width(int start, int end) {
+    return shaped->get_width(shaped_offset + start, shaped_offset + end);
+}
+
 // Breaks text segment into lines, taking into account special cases
 InlineLayoutResult TextSpan::break_segment(
-    const UnicodeString& text,
+    int start,
+    int end,
     const InlineConstraints& constraints,
     bool is_last_segment) {
-    auto chars_count = text.countChar32();
     auto required_width =
         constraints.remaining_line_width - constraints.padding_before;
     auto fit_width = 0.0f;
-    auto fit_chars = break_text(text, font, required_width, &fit_width);
-    if (is_last_segment && fit_chars == chars_count) {
+    auto fit_end =
+        shaped->fit(
+            shaped_offset + start, shaped_offset + end, required_width,
+            &fit_width) -
+        shaped_offset;
+    if (is_last_segment && fit_end == end) {
         // If span fits completely without `padding_after` but does not fit
         // with it, split one char to the next line
         if (fit_width > required_width - constraints.padding_after) {
-            return split(
-                chars_count - 1,
-                measure_text_width(text, font, chars_count - 1));
+            auto split_pos = shaped->prev_position(shaped_offset + end) -
+                             shaped_offset;
+            return split(split_pos, get_width(0, split_pos));
         } else {
             return fit(fit_width);
         }
     }
-    if (fit_chars == 0) {
+    if (fit_end == start) {
         auto at_line_start =
             constraints.total_line_width == constraints.remaining_line_width;
         // If span is at the line start, it should fit at least one char
         // to prevent endless linebreaking, otherwise it should wrap
         if (at_line_start) {
-            auto first_char_width = measure_text_width(text, font, 1);
-            return chars_count == 1 ? fit(first_char_width)
-                                    : split(1, first_char_width);
+            auto first_char_end =
+                shaped->next_position(shaped_offset + start) - shaped_offset;
+            auto first_char_width = get_width(start, first_char_end);
+            if (first_char_end == end) return fit(first_char_width);
+            return split(first_char_end, first_char_width);
         } else {
             return wrap();
         }
     }
-    return split(fit_chars, fit_width);
+    return split(fit_end, fit_width);
 }
 
 InlineLayoutResult TextSpan::layout(InlineConstraints constraints) {
-    font = style.to_sk_font();
-    if (glyph_widths == std::nullopt) {
-        glyph_widths = get_glyph_widths(text, font);
-    }
-    auto chars_count = text.countChar32();
-    if (chars_count == 0) return fit(0);
+    get_shaped_text();
+    auto length = text.length();
+    if (length == 0) return fit(0);
     auto at_line_start =
         constraints.total_line_width == constraints.remaining_line_width;
 
@@ -109,64 +133,68 @@ InlineLayoutResult TextSpan::layout(InlineConstraints constraints) {
         auto required_width = constraints.remaining_line_width -
                               constraints.padding_before -
                               constraints.padding_after;
-        auto text_width = measure_text_width(text, font);
+        auto text_width = get_width(0, length);
         if (text_width <= required_width) return fit(text_width);
         return at_line_start ? fit(text_width) : wrap();
     }
 
     if (linebreak == LineBreak::anywhere) {
-        return break_segment(text, constraints, true);
+        return break_segment(0, length, constraints, true);
     }
 
     // linebreak == normal || linebreak == overflow
-    linebreaker->setText(text);
-    auto first = linebreaker->first();
-    auto start = first;
-    auto end = linebreaker->next();
-    auto next = linebreaker->next();
+    // Segments are bounded by the cached break positions that lie inside of
+    // this span, and by the start and the end of the span.
+    auto& all_breaks = get_line_breaks();
+    auto first_break = std::upper_bound(
+        all_breaks.begin(), all_breaks.end(), breaks_offset);
+    auto last_break = std::lower_bound(
+        first_break, all_breaks.end(), breaks_offset + length);
+    auto count = static_cast<int>(last_break - first_break) + 2;
+    auto boundary = [&](int index) {
+        if (index == 0) return 0;
+        if (index == count - 1) return length;
+        return *(first_break + index - 1) - breaks_offset;
+    };
+
+    auto index = 0;  // Index of the start of the current segment
     auto fit_width = 0.0f;
     auto segment_width = 0.0f;
     auto paddings_width = 0.0f;
-    // Iterate through break points
-    while (end != BreakIterator::DONE) {
-        auto substring = text.tempSubString(start, end - start);
+    // Iterate through break points, widths of the segments are taken from
+    // the shaped text without measuring
+    while (index < count - 1) {
         // Line must have space for `padding_before` to fit first segment, and
         // `padding_after` to fit last segment, but they are not counted as own
         // span's width.
-        if (start == first) paddings_width += constraints.padding_before;
-        if (next == BreakIterator::DONE) {
-            paddings_width += constraints.padding_after;
-        }
-        segment_width = measure_text_width(substring, font);
+        if (index == 0) paddings_width += constraints.padding_before;
+        if (index == count - 2) paddings_width += constraints.padding_after;
+        segment_width = get_width(boundary(index), boundary(index + 1));
         if (fit_width + segment_width + paddings_width >
             constraints.remaining_line_width) {
             break;
         }
         fit_width += segment_width;
-        start = end;
-        end = next;
-        next = linebreaker->next();
+        index++;
     }
 
-    if (at_line_start && start == first && end != BreakIterator::DONE) {
-        auto is_last_segment = linebreaker->next() == BreakIterator::DONE;
+    if (at_line_start && index == 0) {
+        auto end = boundary(1);
         if (linebreak == LineBreak::normal) {
             // If span is at the line start, it should fit at least one segment,
             // to prevent endless linebreaking
-            return is_last_segment ? fit(segment_width)
-                                   : split(end, segment_width);
+            return count == 2 ? fit(segment_width) : split(end, segment_width);
         } else if (linebreak == LineBreak::overflow) {
-            auto segment_text = text.tempSubString(start, end - start);
-            return break_segment(segment_text, constraints, true);
+            return break_segment(0, end, constraints, true);
         }
     }
 
-    if (end == BreakIterator::DONE) {
+    if (index == count - 1) {
         return fit(fit_width);
-    } else if (start == linebreaker->first()) {
+    } else if (index == 0) {
         return wrap();
     } else {
-        return split(start, fit_width);
+        return split(boundary(index), fit_width);
     }
 }
 
@@ -174,6 +202,15 @@ std::shared_ptr<Element> TextSpan::render() {
     return std::make_shared<TextElement>(text, style);
 }
 
+bool TextSpan::update_element(Element* elem) {
+    auto text_elem = dynamic_cast<TextElement*>(elem);
+    if (text_elem == nullptr) return false;
+    text_elem->text = text;
+    text_elem->style = style;
+    text_elem->invalidate_layout();
+    return true;
+}
+
 UnicodeString TextSpan::get_text() { return text; }
 
 int TextSpan::get_text_length() {
@@ -188,12 +225,10 @@ std::shared_ptr<Span> TextSpan::slice(int start, int end) {
 }
 
 int TextSpan::get_offset_at_position(float position) {
-    font = style.to_sk_font();
-    if (glyph_widths == std::nullopt) {
-        glyph_widths = get_glyph_widths(text, font);
-    }
-    auto measured_width = 0.0f;
-    return find_break_position(position, glyph_widths.value(), &measured_width);
+    auto& shaped_text = get_shaped_text();
+    return shaped_text.find_position(
+               shaped_offset, shaped_offset + text.length(), position) -
+           shaped_offset;
 }
 
 }  // namespace aardvark::inline_layout
@@ -16,68 +16,6 @@ float measure_text_width(
         text.getBuffer(), byte_length, SkTextEncoding::kUTF16);
 };
 
-std::vector<float> get_glyph_widths(
-    const UnicodeString& text, const SkFont& font) {
-    auto count = text.length(); 
-    if (count == 0) return std::vector<float>();
-    SkGlyphID glyphs[count]; // countChar32
-    auto glyph_count = font.textToGlyphs(
-        text.getBuffer(),        // text
-        count * 2,               // byteLength
-        SkTextEncoding::kUTF16,  // encoding
-        glyphs,                  // glyphs
-        count                    // maxGlyphCount
-    );
-    auto widths = std::vector<float>(glyph_count);
-    font.getWidths(glyphs, glyph_count, widths.data());
-    return widths;
-}
-
-int find_break_position(
-    float max_width, std::vector<float> glyph_widths, float* measured_width) {
-    auto measured_count = 0;
-    *measured_width = 0;
-    for (int i = 0; i < glyph_widths.size(); i++) {
-        if (*measured_width + glyph_widths[i] / 2 > max_width) break;
-        measured_count++;
-        *measured_width += glyph_widths[i];
-    }
-    return measured_count;
-}
-
-int break_text(
-    const UnicodeString& text,
-    const SkFont& font,
-    float max_width,
-    float* measured_width) {
-    auto count = text.length();
-    if (count == 0) {
-        *measured_width = 0;
-        return 0;
-    }
-    
-    // TODO only once per text span
-    SkGlyphID glyphs[count]; // countChar32
-    auto glyph_count = font.textToGlyphs(
-        text.getBuffer(),        // text
-        count * 2,               // byteLength
-        SkTextEncoding::kUTF16,  // encoding
-        glyphs,                  // glyphs
-        count                    // maxGlyphCount
-    );
-    float widths[glyph_count];
-    font.getWidths(glyphs, glyph_count, widths);
-    
-    auto measured_count = 0;
-    *measured_width = 0;
-    for (int i = 0; i < glyph_count; i++) {
-        if (*measured_width + widths[i] > max_width) break;
-        measured_count++;
-        *measured_width += widths[i];
-    }
-    return measured_count;
-};
-
 std::string icu_to_std_string(const UnicodeString& text) {
     std::string std_string;
     text.toUTF8String(std_string);
@@ -103,26 +41,62 @@ LineMetrics calc_combined_metrics(
     };
 }
 
-void render_spans(
+// Updates element that was rendered for another span, returns `false` when it
+// can not be used for the span
+bool recycle_element(
+    Span* span,
+    Element* elem,
+    const SizeConstraints& size_constraints,
+    const Alignment& align) {
+    auto aligned = dynamic_cast<AlignedElement*>(elem);
+    if (aligned == nullptr) return false;
+    auto sized = dynamic_cast<SizedElement*>(aligned->child.get());
+    if (sized == nullptr || !span->update_element(sized->child.get())) {
+        return false;
+    }
+    sized->size_constraints = size_constraints;
+    sized->invalidate_layout();
+    aligned->alignment = align;
+    aligned->invalidate_layout();
+    return true;
+}
+
+int render_spans(
     const std::vector<std::shared_ptr<Span>>& spans,
     const LineMetrics& metrics,
     const Position& offset,
     std::vector<std::shared_ptr<Element>>* container,
-    Element* parent) {
+    Element* parent,
+    std::vector<std::shared_ptr<Element>>* recycled) {
     auto current_width = 0.0f;
+    auto reused = 0;
     for (auto& span : spans) {
-        auto elem = span->render();
         auto sizeConstraints = SizeConstraints{
             Value::abs(span->width), Value::abs(span->metrics.height)};
         auto align = Alignment::top_left(
             Value::abs(span->vert_align(metrics, span->metrics) + offset.top),
             Value::abs(current_width + offset.left));
-        auto aligned = std::make_shared<AlignedElement>(
-            std::make_shared<SizedElement>(elem, sizeConstraints), align);
+        std::shared_ptr<Element> aligned = nullptr;
+        if (recycled != nullptr && !recycled->empty()) {
+            // Element that can not be recycled is dropped
+            auto candidate = std::move(recycled->back());
+            recycled->pop_back();
+            if (recycle_element(
+                    span.get(), candidate.get(), sizeConstraints, align)) {
+                aligned = std::move(candidate);
+                reused++;
+            }
+        }
+        if (aligned == nullptr) {
+            aligned = std::make_shared<AlignedElement>(
+                std::make_shared<SizedElement>(span->render(), sizeConstraints),
+                align);
+        }
         aligned->parent = parent;
         container->emplace_back(aligned);
         current_width += span->width;
     }
+    return reused;
 }
 
 SkPaint make_default_paint() {
@@ -42,7 +42,17 @@ void Layer::paint_layer(Layer* layer, Position pos, float opacity) {
     paint.setAntiAlias(true);
     paint.setAlpha(opacity * 255);
     auto sampling = SkSamplingOptions(SkFilterMode::kNearest, SkMipmapMode::kNone);
-    canvas->drawImage(layer->get_snapshot(), pos.left, pos.top, sampling, &paint);
+    auto snapshot = layer->get_snapshot();
+    if (snapshot->width() == layer->size.width &&
+        snapshot->height() == layer->size.height) {
+        canvas->drawImage(snapshot, pos.left, pos.top, sampling, &paint);
+        return;
+    }
+    // Surface is larger than the layer, only the used area is painted
+    auto src = SkRect::MakeWH(layer->size.width, layer->size.height);
+    auto dst = src.makeOffset(pos.left, pos.top);
+    canvas->drawImageRect(snapshot, src, dst, sampling, &paint,
+                          SkCanvas::kStrict_SrcRectConstraint);
 };
 
 const int STENCIL_BITS = 8;
@@ -96,11 +106,27 @@ std::shared_ptr<Layer> Layer::make_screen_layer(sk_sp<GrDirectContext> gr_contex
 
 std::shared_ptr<Layer> Layer::make_offscreen_layer(sk_sp<GrDirectContext> gr_context,
                                                    Size size) {
+    return std::make_shared<Layer>(make_offscreen_surface(gr_context, size));
+};
+
+std::shared_ptr<Layer> Layer::make_raster_layer(Size size) {
+    return std::make_shared<Layer>(make_offscreen_surface(nullptr, size));
+};
+
+sk_sp<SkSurface> Layer::make_offscreen_surface(
+    sk_sp<GrDirectContext> gr_context, Size size) {
     const SkImageInfo info =
         SkImageInfo::MakeN32Premul(size.width, size.height);
     auto props = SkSurfaceProps(SkSurfaceProps::kUseDeviceIndependentFonts_Flag,
       kUnknown_SkPixelGeometry);
-    auto target =
+    if (gr_context == nullptr) {
+        auto surface = SkSurface::MakeRaster(info, &props);
+        if (surface == nullptr) {
+            Log::error("[Layer] Cannot create raster layer surface");
+        }
+        return surface;
+    }
+    auto surface =
         SkSurface::MakeRenderTarget(
           gr_context.get(),
           SkBudgeted::kNo,
@@ -108,14 +134,10 @@ std::shared_ptr<Layer> Layer::make_offscreen_layer(sk_sp<GrDirectContext> gr_con
           MSAA_SAMPLE_COUNT, // sampleCount
           &props
         );
-    if (target == nullptr) {
-		Log::error("[Layer] Cannot create offscreen layer render target");
-    }
-    auto surface(target);
     if (surface == nullptr) {
 		Log::error("[Layer] Cannot create offscreen layer surface");
     }
-    return std::make_shared<Layer>(surface);
+    return surface;
 };
 
 }  // namespace aardvark
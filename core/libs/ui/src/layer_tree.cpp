@@ -7,6 +7,44 @@ LayerTree::LayerTree(Element* element) {
     transform.reset();
 };
 
+SkMatrix LayerTree::get_compose_transform() {
+    auto matrix = transform;
+    if (animated.translate_left != 0 || animated.translate_top != 0) {
+        matrix.preTranslate(animated.translate_left, animated.translate_top);
+    }
+    if (animated.scale != 1 || animated.rotation != 0) {
+        auto center_left = element->size.width / 2;
+        auto center_top = element->size.height / 2;
+        matrix.preRotate(animated.rotation, center_left, center_top);
+        matrix.preScale(
+            animated.scale, animated.scale, center_left, center_top);
+    }
+    return matrix;
+}
+
+void LayerTree::set_clip(std::optional<Clip> new_clip) {
+    clip = std::move(new_clip);
+    is_transformed_clip_valid = false;
+}
+
+const std::optional<Clip>& LayerTree::get_transformed_clip(
+    const SkMatrix& transform) {
+    if (is_transformed_clip_valid && transformed_clip_matrix == transform) {
+        return transformed_clip;
+    }
+    transformed_clip = std::nullopt;
+    if (clip != std::nullopt) {
+        SkMatrix inverted_transform;
+        if (!transform.invert(&inverted_transform)) {
+            inverted_transform.reset();
+        }
+        transformed_clip = clip.value().transform(inverted_transform);
+    }
+    transformed_clip_matrix = transform;
+    is_transformed_clip_valid = true;
+    return transformed_clip;
+}
+
 void LayerTree::add(LayerTreeNode item) {
     children.push_back(item);
     if (auto tree = std::get_if<LayerTree*>(&item)) (*tree)->parent = this;
@@ -1,5 +1,6 @@
 #include "platforms/desktop/desktop_app.hpp"
 #include "utils/log.hpp"
+#include "utils/profiler.hpp"
 
 #include <chrono>
 #include <iostream>
@@ -44,6 +45,11 @@ void window_size_callback(GLFWwindow* window, int width, int height) {
     DesktopApp::dispatch_event(window, WindowResizeEvent{width, height});
 }
 
+void window_refresh_callback(GLFWwindow* glfw_window) {
+    auto window = DesktopWindow::get(glfw_window);
+    window->app->refresh_window(window);
+}
+
 // Mouse events
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
     auto event = ScrollEvent{
@@ -98,8 +104,21 @@ void char_callback(GLFWwindow* window, unsigned int codepoint) {
     DesktopApp::dispatch_event(window, CharEvent{(int)codepoint});
 }
 
+// Minimal interval between frames in microseconds
 const auto FRAME_TIME = 16000;
 
+// Maximal time of waiting for events while there are pending io operations
+// in microseconds
+const auto IO_POLL_TIME = 5000;
+
+DesktopApp::DesktopApp(std::shared_ptr<EventLoop> event_loop)
+    : event_loop(std::move(event_loop)) {
+    start_time = Clock::now();
+    next_frame_time = start_time;
+    // Posting callbacks or timeouts from any thread wakes up the loop
+    this->event_loop->wakeup_handler = []() { glfwPostEmptyEvent(); };
+}
+
 void DesktopApp::dispatch_event(GLFWwindow* glfw_window, Event event) {
     auto window = DesktopWindow::get(glfw_window);
     window->app->handle_event(window, event);
@@ -117,6 +136,7 @@ std::shared_ptr<DesktopWindow> DesktopApp::create_window(
     glfwSetWindowCloseCallback(glfw_window, window_close_callback);
     glfwSetWindowIconifyCallback(glfw_window, window_iconify_callback);
     glfwSetWindowSizeCallback(glfw_window, window_size_callback);
+    glfwSetWindowRefreshCallback(glfw_window, window_refresh_callback);
     // Mouse events
     glfwSetScrollCallback(glfw_window, scroll_callback);
     glfwSetCursorPosCallback(glfw_window, cursor_pos_callback);
@@ -126,7 +146,11 @@ std::shared_ptr<DesktopWindow> DesktopApp::create_window(
     glfwSetCharCallback(glfw_window, char_callback);
     auto gr_context = GrDirectContext::MakeGL();
     auto screen = Layer::make_screen_layer(gr_context);
-    documents[window.get()] = std::make_shared<Document>(gr_context, screen);
+    auto document = std::make_shared<Document>(gr_context, screen);
+    document->request_frame_handler = [this]() { request_frame(); };
+    document->event_loop = event_loop.get();
+    documents[window.get()] = document;
+    request_frame();
     return window;
 }
 
@@ -140,42 +164,94 @@ void DesktopApp::destroy_window(std::shared_ptr<DesktopWindow> window) {
     windows.erase(std::find(windows.begin(), windows.end(), window));
 };
 
-void DesktopApp::stop() { should_stop = true; };
+void DesktopApp::stop() {
+    should_stop = true;
+    glfwPostEmptyEvent();
+};
 
-void DesktopApp::run(std::function<void(void)> update_callback) {
+void DesktopApp::run(FrameCallback update_callback) {
     should_stop = false;
-    event_loop->post_callback(
-        [this, update_callback]() { render(update_callback); });
+    this->update_callback = std::move(update_callback);
+    request_frame();
+    // Loop is posted directly to the io context, because posting callbacks
+    // through the event loop wakes it up
+    boost::asio::post(event_loop->io, [this]() { loop(); });
 };
 
-void DesktopApp::render(std::function<void(void)> update_callback) {
+void DesktopApp::request_frame() {
+    if (!frame_requested.exchange(true)) glfwPostEmptyEvent();
+}
+
+// Each iteration of the loop is a separate callback, so callbacks and timeouts
+// of the event loop are handled between iterations.
+void DesktopApp::loop() {
     if (should_stop) return;
+    wait_events();
+    glfwPollEvents();
+    if (frame_requested && Clock::now() >= next_frame_time) render();
+    boost::asio::post(event_loop->io, [this]() { loop(); });
+}
 
-    if (update_callback) update_callback();
+// Sleeps until an input event, a frame request, a posted callback or until the
+// next timeout is expired. Completions of io operations do not wake up the
+// loop, so the sleep is limited while some of them are pending.
+void DesktopApp::wait_events() {
+    if (event_loop->has_pending_callbacks()) return;
+    auto now = Clock::now();
+    auto wake_time = event_loop->get_next_expiry();
+    if (frame_requested && (wake_time == std::nullopt ||
+                            next_frame_time < wake_time.value())) {
+        wake_time = next_frame_time;
+    }
+    if (event_loop->has_pending_io()) {
+        auto io_poll_time = now + std::chrono::microseconds(IO_POLL_TIME);
+        if (wake_time == std::nullopt || io_poll_time < wake_time.value()) {
+            wake_time = io_poll_time;
+        }
+    }
+    if (wake_time == std::nullopt) {
+        glfwWaitEvents();
+    } else if (wake_time.value() > now) {
+        auto timeout = std::chrono::duration<double>(wake_time.value() - now);
+        glfwWaitEventsTimeout(timeout.count());
+    }
+}
 
-    auto start = std::chrono::high_resolution_clock::now();
-    glfwPollEvents();
+void DesktopApp::render() {
+    auto profiler_scope = ProfilerScope("DesktopApp::render");
+    auto start = Clock::now();
+    frame_requested = false;
+    next_frame_time = start + std::chrono::microseconds(FRAME_TIME);
+
+    if (update_callback) {
+        auto frame_time =
+            std::chrono::duration<double, std::milli>(start - start_time);
+        update_callback(frame_time.count());
+    }
 
     bool rendered = false;
     for (auto& window : windows) {
         window->make_current();
-        rendered = rendered || documents[window.get()]->render();
-        window->swap_now();
+        // Buffers are swapped only when the screen was recomposed
+        auto composed = documents[window.get()]->render();
+        if (composed) window->swap_now();
+        rendered = rendered || composed;
     }
-    auto end = std::chrono::high_resolution_clock::now();
+    auto end = Clock::now();
     auto time =
         std::chrono::duration_cast<std::chrono::microseconds>(end - start)
             .count();
     if (rendered) {
         Log::info("[DesktopApp] frame time {}ms", time / 1000.0);
     }
-    auto timeout = (time < FRAME_TIME) ? (FRAME_TIME - time) : 0;
-    event_loop->set_timeout(
-        [this, update_callback]() { render(update_callback); }, timeout);
-    // std::bind(&DesktopApp::render, this, update_callback), timeout);
+}
+
+void DesktopApp::refresh_window(DesktopWindow* window) {
+    documents[window]->invalidate_screen();
 }
 
 void DesktopApp::handle_event(DesktopWindow* window, Event event) {
+    auto profiler_scope = ProfilerScope("DesktopApp::handle_event");
     auto document = documents[window];
     if (event_handler) event_handler(this, event);
 
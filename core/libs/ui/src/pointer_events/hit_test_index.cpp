@@ -0,0 +1,79 @@
+#include "pointer_events/hit_test_index.hpp"
+
+#include <algorithm>
+
+namespace aardvark {
+
+// Maximal number of rects in the leaf node
+const int LEAF_SIZE = 8;
+
+bool contains_inclusive(const SkRect& rect, SkPoint point) {
+    return point.x() >= rect.left() && point.x() <= rect.right() &&
+           point.y() >= rect.top() && point.y() <= rect.bottom();
+}
+
+void HitTestIndex::build(std::vector<SkRect> rects) {
+    this->rects = std::move(rects);
+    order.resize(this->rects.size());
+    for (auto i = 0; i < order.size(); i++) order[i] = i;
+    nodes.clear();
+    if (!order.empty()) build_node(0, order.size());
+}
+
+// Splits rects at the median of the longer axis of their bounds
+int HitTestIndex::build_node(int start, int count) {
+    auto bounds = SkRect::MakeEmpty();
+    for (auto i = start; i < start + count; i++) {
+        // `join` ignores empty rects, so bounds are extended explicitly
+        auto& rect = rects[order[i]];
+        if (i == start) {
+            bounds = rect;
+        } else {
+            bounds.setLTRB(
+                std::min(bounds.left(), rect.left()),
+                std::min(bounds.top(), rect.top()),
+                std::max(bounds.right(), rect.right()),
+                std::max(bounds.bottom(), rect.bottom()));
+        }
+    }
+    auto index = static_cast<int>(nodes.size());
+    nodes.push_back(Node{bounds, start, count});
+    if (count <= LEAF_SIZE) return index;
+
+    auto horizontal = bounds.width() > bounds.height();
+    auto begin = order.begin() + start;
+    auto middle = begin + count / 2;
+    std::nth_element(
+        begin, middle, begin + count, [&](int a, int b) {
+            return horizontal ? rects[a].centerX() < rects[b].centerX()
+                              : rects[a].centerY() < rects[b].centerY();
+        });
+    auto left = build_node(start, count / 2);
+    auto right = build_node(start + count / 2, count - count / 2);
+    nodes[index].left = left;
+    nodes[index].right = right;
+    return index;
+}
+
+void HitTestIndex::query(SkPoint point, std::vector<int>* result) const {
+    if (nodes.empty()) return;
+    int stack[64];
+    auto stack_size = 0;
+    stack[stack_size++] = 0;
+    while (stack_size > 0) {
+        auto& node = nodes[stack[--stack_size]];
+        if (!contains_inclusive(node.bounds, point)) continue;
+        if (node.left == -1) {
+            for (auto i = node.start; i < node.start + node.count; i++) {
+                if (contains_inclusive(rects[order[i]], point)) {
+                    result->push_back(order[i]);
+                }
+            }
+        } else {
+            stack[stack_size++] = node.left;
+            stack[stack_size++] = node.right;
+        }
+    }
+}
+
+}  // namespace aardvark
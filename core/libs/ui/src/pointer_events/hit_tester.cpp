@@ -1,26 +1,33 @@
 #include "pointer_events/hit_tester.hpp"
 
+#include <algorithm>
+
+#include "utils/profiler.hpp"
+
 namespace aardvark {
 
 std::vector<std::weak_ptr<Element>> HitTester::test(float left, float top) {
-    test_element(document->root, left, top);
+    auto profiler_scope = ProfilerScope("HitTester::test");
+    auto root = document->root.get();
+    auto point = SkPoint::Make(
+        left - root->rel_position.left, top - root->rel_position.top);
+    if (root->clip == std::nullopt ||
+        root->clip.value().contains(point.x(), point.y())) {
+        test_boundary(root, point, -1);
+    }
 
     auto hit_elements = std::vector<std::shared_ptr<Element>>();
     // Iterate elements from top to bottom
-    auto it = elements_under_pointer.rbegin();
-    while (it != elements_under_pointer.rend()) {
-        auto elem = *it;
+    auto hit = static_cast<int>(elements_under_pointer.size()) - 1;
+    while (hit != -1) {
+        auto& elem = elements_under_pointer[hit];
         hit_elements.push_back(elem);
         auto mode = elem->get_hit_test_mode();
         if (mode == HitTestMode::PassThrough) {
-            it++;  // Pass to the next element
+            hit--;  // Pass to the next element
         } else if (mode == HitTestMode::PassToParent) {
-            // Pass to next element that is parent of passing
-            it++;
-            while (it != elements_under_pointer.rend()) {
-                if ((*it)->is_parent_of(elem.get())) break;
-                it++;
-            }
+            // Pass to the closest element that is parent of passing
+            hit = hit_parents[hit];
         } else if (mode == HitTestMode::Absorb) {
             break;  // Do not pass event handling
         }
@@ -33,45 +40,138 @@ std::vector<std::weak_ptr<Element>> HitTester::test(float left, float top) {
         }
     }
 
-    transform.reset();
     elements_under_pointer.clear();
+    hit_parents.clear();
 
     return hit_elements_with_responders;
 }
 
-void HitTester::test_element(std::shared_ptr<Element> elem, float left,
-                             float top) {
-    SkScalar prev_transform[9];
-    transform.get9(prev_transform);
+void HitTester::invalidate(Element* elem) {
+    auto current = elem;
+    while (current != nullptr && !current->is_repaint_boundary) {
+        current = current->parent;
+    }
+    if (current != nullptr && current->hit_test_index != nullptr) {
+        current->hit_test_index->is_valid = false;
+    }
+}
+
+void HitTester::test_boundary(
+    Element* boundary, SkPoint point, int parent_hit) {
+    SkMatrix inverse;
+    if (boundary->layer_tree->get_compose_transform().invert(&inverse)) {
+        point = inverse.mapXY(point.x(), point.y());
+    }
 
-    transform.postTranslate(-elem->rel_position.left, -elem->rel_position.top);
+    if (boundary->hit_test_index == nullptr) {
+        boundary->hit_test_index = std::make_shared<BoundaryHitTestIndex>();
+    }
+    // Index can be replaced while testing nested boundaries, because handlers
+    // are not called during the hit test, this is only for safety.
+    auto index_sp = boundary->hit_test_index;
+    auto index = index_sp.get();
+    if (!index->is_valid) build_index(boundary, index);
 
-    bool clipped = false;
-    if (elem->clip != std::nullopt) {
-        // Element's clip is relative to element's position
-        auto transformed = SkPoint{left, top};
-        transform.mapPoints(&transformed, 1);
-        clipped =
-            !elem->clip.value().contains(transformed.x(), transformed.y());
+    // Candidates are elements whose bounds contain the point, and all nested
+    // boundaries, because their contents can be transformed or overflow them.
+    auto candidates = std::vector<int>();
+    index->index.query(point, &candidates);
+    for (auto& candidate : candidates) {
+        candidate = index->indexed_entries[candidate];
     }
+    candidates.insert(
+        candidates.end(), index->boundaries.begin(), index->boundaries.end());
+    // Entries are stored in paint order
+    std::sort(candidates.begin(), candidates.end());
 
-    if (!clipped) {
-        if (elem->is_repaint_boundary) {
-            SkMatrix inverse;
-            auto inverted = elem->layer_tree->transform.invert(&inverse);
-            if (inverted) transform.postConcat(inverse);
+    // Hits whose descendants can be tested next, with the ends of their
+    // entries. Entries of descendants follow the entry of the element.
+    auto open_hits = std::vector<std::pair<int, int>>();
+    for (auto entry_index : candidates) {
+        if (is_clipped(index, entry_index, point)) continue;
+        auto& entry = index->entries[entry_index];
+        while (!open_hits.empty() && open_hits.back().first <= entry_index) {
+            open_hits.pop_back();
+        }
+        auto parent = open_hits.empty() ? parent_hit : open_hits.back().second;
+        auto rel_point = SkPoint::Make(
+            point.x() - entry.offset.left, point.y() - entry.offset.top);
+        if (entry_index != 0 && entry.elem->is_repaint_boundary) {
+            test_boundary(entry.elem, rel_point, parent);
+            continue;
         }
-        auto rel_pos = SkPoint{left, top};
-        transform.mapPoints(&rel_pos, 1);
-        if (elem->get_hit_test_mode() != HitTestMode::Disabled &&
-            elem->hit_test(rel_pos.x(), rel_pos.y())) {
-            elements_under_pointer.push_back(elem);
+        if (entry.elem->get_hit_test_mode() != HitTestMode::Disabled &&
+            entry.elem->hit_test(rel_point.x(), rel_point.y())) {
+            open_hits.emplace_back(
+                entry.end_entry,
+                static_cast<int>(elements_under_pointer.size()));
+            elements_under_pointer.push_back(entry.elem->shared_from_this());
+            hit_parents.push_back(parent);
         }
-        elem->visit_children(std::bind(&HitTester::test_element, this,
-                                       std::placeholders::_1, left, top));
     }
-    
-    transform.set9(prev_transform);
-};
+}
+
+// Checks clips of the element and its ancestors inside of the boundary
+bool HitTester::is_clipped(
+    BoundaryHitTestIndex* index, int entry_index, SkPoint point) {
+    auto clip_entry = index->entries[entry_index].clip_entry;
+    while (clip_entry != -1) {
+        auto& entry = index->entries[clip_entry];
+        // Element's clip is relative to element's position
+        if (!entry.elem->clip.value().contains(
+                point.x() - entry.offset.left, point.y() - entry.offset.top)) {
+            return true;
+        }
+        clip_entry = entry.parent_clip_entry;
+    }
+    return false;
+}
+
+void HitTester::build_index(Element* boundary, BoundaryHitTestIndex* index) {
+    index->entries.clear();
+    index->boundaries.clear();
+    index->indexed_entries.clear();
+    auto rects = std::vector<SkRect>();
+    auto origin = boundary->abs_position;
+
+    // Clip of the boundary itself is checked in the parent boundary
+    index->entries.push_back(
+        BoundaryHitTestIndex::Entry{boundary, Position{0, 0}, -1, -1, 1});
+    index->indexed_entries.push_back(0);
+    rects.push_back(
+        SkRect::MakeWH(boundary->size.width, boundary->size.height));
+
+    std::function<void(Element*, int)> add_children;
+    add_children = [&](Element* elem, int clip_entry) {
+        elem->visit_children([&](std::shared_ptr<Element>& child) {
+            auto entry_index = static_cast<int>(index->entries.size());
+            auto offset = Position{child->abs_position.left - origin.left,
+                                   child->abs_position.top - origin.top};
+            auto child_clip_entry =
+                child->clip != std::nullopt ? entry_index : clip_entry;
+            index->entries.push_back(BoundaryHitTestIndex::Entry{
+                child.get(), offset, child_clip_entry, clip_entry,
+                entry_index + 1});
+            if (child->is_repaint_boundary) {
+                index->boundaries.push_back(entry_index);
+                return;
+            }
+            index->indexed_entries.push_back(entry_index);
+            rects.push_back(SkRect::MakeXYWH(
+                offset.left,
+                offset.top,
+                child->size.width,
+                child->size.height));
+            add_children(child.get(), child_clip_entry);
+            index->entries[entry_index].end_entry =
+                static_cast<int>(index->entries.size());
+        });
+    };
+    add_children(boundary, -1);
+    index->entries[0].end_entry = static_cast<int>(index->entries.size());
+
+    index->index.build(std::move(rects));
+    index->is_valid = true;
+}
 
 }  // namespace aardvark
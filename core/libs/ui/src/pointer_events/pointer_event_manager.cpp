@@ -1,5 +1,9 @@
 #include "pointer_events/pointer_event_manager.hpp"
 
+#include "utils/profiler.hpp"
+
+#include <unordered_set>
+
 namespace aardvark {
 
 template <class K, class V>
@@ -7,19 +11,25 @@ bool map_contains(const std::map<K, V>& map, const K& key) {
     return map.find(key) != map.end();
 }
 
-template <typename A, typename B>
-inline bool wptr_equals(const std::weak_ptr<A>& a, const std::weak_ptr<B>& b) {
-    return !a.expired() && a.lock() == b.lock();
+std::unordered_set<Element*> lock_elems(
+    const std::vector<std::weak_ptr<Element>>& elems) {
+    auto res = std::unordered_set<Element*>();
+    for (auto& elem_wptr : elems) {
+        if (auto elem = elem_wptr.lock()) res.insert(elem.get());
+    }
+    return res;
 }
 
-bool contains_elem(
-    std::vector<std::weak_ptr<Element>>* elems, std::weak_ptr<Element> target) {
-    auto pred = [&target](std::weak_ptr<Element>& elem) {
-        return wptr_equals(elem, target);
-    };
-    auto res = std::find_if(elems->begin(), elems->end(), pred);
-    return res != elems->end();
-};
+void append_samples(const PointerEvent& event,
+                    std::vector<PointerEventSample>* samples) {
+    if (event.coalesced.empty()) {
+        samples->push_back(
+            PointerEventSample{event.timestamp, event.left, event.top});
+    } else {
+        samples->insert(
+            samples->end(), event.coalesced.begin(), event.coalesced.end());
+    }
+}
 
 PointerEventManager::PointerEventManager(Document* document)
     : document(document) {
@@ -42,6 +52,53 @@ std::shared_ptr<Connection> PointerEventManager::start_tracking_pointer(
 }
 
 void PointerEventManager::handle_event(const PointerEvent& event) {
+    if (event.action == PointerAction::pointer_move) {
+        stats.raw_move_events++;
+        if (coalesce_move_events) {
+            auto it = pending_moves.find(event.pointer_id);
+            if (it == pending_moves.end()) {
+                auto pending = event;
+                pending.coalesced.clear();
+                append_samples(event, &pending.coalesced);
+                pending_moves.emplace(event.pointer_id, std::move(pending));
+                document->request_frame();
+            } else {
+                auto& pending = it->second;
+                auto samples = std::move(pending.coalesced);
+                append_samples(event, &samples);
+                pending = event;
+                pending.coalesced = std::move(samples);
+                stats.coalesced_move_events++;
+            }
+            return;
+        }
+    }
+    // Pending moves happened before this event, so they are dispatched first
+    flush_pending_events();
+    dispatch_event(event);
+}
+
+void PointerEventManager::flush_pending_events() {
+    if (pending_moves.empty()) return;
+    auto profiler_scope =
+        ProfilerScope("PointerEventManager::flush_pending_events");
+    auto moves = std::move(pending_moves);
+    pending_moves.clear();
+    if (Profiler::is_enabled()) {
+        auto raw_events = 0;
+        for (auto& [pointer_id, event] : moves) {
+            raw_events += event.coalesced.size();
+        }
+        Profiler::record_counter("pointer_move_events", raw_events);
+    }
+    for (auto& [pointer_id, event] : moves) dispatch_event(event);
+}
+
+void PointerEventManager::dispatch_event(const PointerEvent& event) {
+    auto profiler_scope = ProfilerScope("PointerEventManager::handle_event");
+    if (event.action == PointerAction::pointer_move) {
+        stats.dispatched_move_events++;
+    }
     before_signal(event);
     call_responders_handlers(event);
     if (map_contains(pointers_signals, event.pointer_id)) {
@@ -78,13 +135,12 @@ void PointerEventManager::call_responders_handlers(const PointerEvent& event) {
             }
         }
     } else {
+        auto hit_set = lock_elems(hit_elems);
+        auto prev_hit_set = lock_elems(*pointer_prev_hit_elems);
         // Call `remove` handlers of responders that are no longer hit
         for (auto& elem_wptr : *pointer_prev_hit_elems) {
             if (auto elem = elem_wptr.lock()) {
-                if (!contains_elem(
-                        const_cast<std::vector<std::weak_ptr<Element>>*>(
-                            &hit_elems),
-                        elem_wptr)) {
+                if (hit_set.find(elem.get()) == hit_set.end()) {
                     elem->get_responder()->handler(
                         event, ResponderEventType::remove);
                 }
@@ -94,7 +150,7 @@ void PointerEventManager::call_responders_handlers(const PointerEvent& event) {
         for (auto& elem_wptr : hit_elems) {
             if (auto elem = elem_wptr.lock()) {
                 auto event_type =
-                    contains_elem(pointer_prev_hit_elems, elem_wptr)
+                    prev_hit_set.find(elem.get()) != prev_hit_set.end()
                         ? ResponderEventType::update
                         : ResponderEventType::add;
                 elem->get_responder()->handler(event, event_type);
@@ -0,0 +1,111 @@
+#include "surface_pool.hpp"
+
+#include <algorithm>
+
+namespace aardvark {
+
+// Size of the smallest bucket step in pixels
+const int MIN_BUCKET_STEP = 32;
+
+// Rounds dimension up to the multiple of the step, that is 1/8 of the largest
+// power of two that is not greater than the dimension. Dimensions of at least
+// 256 pixels grow by less than 1/8, so the area grows by less than 27%.
+// Smaller dimensions are rounded to the multiple of the minimal step.
+int round_to_bucket(int value) {
+    if (value <= 0) return 0;
+    int pow = 1;
+    while (pow * 2 <= value) pow <<= 1;
+    auto step = std::max(MIN_BUCKET_STEP, pow / 8);
+    return (value + step - 1) / step * step;
+}
+
+uint64_t make_key(SkISize size) {
+    return (static_cast<uint64_t>(size.width()) << 32) |
+           static_cast<uint32_t>(size.height());
+}
+
+SurfacePool::SurfacePool(sk_sp<GrDirectContext> gr_context, size_t budget)
+    : gr_context(std::move(gr_context)), budget(budget){};
+
+Size SurfacePool::layer_size(Size size) {
+    return Size{static_cast<float>(static_cast<int>(size.width)),
+                static_cast<float>(static_cast<int>(size.height))};
+}
+
+SkISize SurfacePool::bucket_size(Size size) {
+    return SkISize::Make(round_to_bucket(static_cast<int>(size.width)),
+                         round_to_bucket(static_cast<int>(size.height)));
+}
+
+bool SurfacePool::fits(Layer* layer, Size size) {
+    auto surface_size =
+        SkISize::Make(layer->surface->width(), layer->surface->height());
+    return surface_size == bucket_size(size);
+}
+
+std::shared_ptr<Layer> SurfacePool::acquire(Size size) {
+    auto surface_size = bucket_size(size);
+    auto bucket = buckets.find(make_key(surface_size));
+    std::shared_ptr<Layer> layer;
+    if (bucket == buckets.end()) {
+        stats.misses++;
+        layer = std::make_shared<Layer>(Layer::make_offscreen_surface(
+            gr_context,
+            Size{static_cast<float>(surface_size.width()),
+                 static_cast<float>(surface_size.height())}));
+    } else {
+        stats.hits++;
+        auto it = bucket->second.back();
+        layer = std::make_shared<Layer>(it->surface);
+        layer->reset();
+        erase(it);
+    }
+    layer->size = layer_size(size);
+    return layer;
+}
+
+void SurfacePool::release(std::shared_ptr<Layer> layer) {
+    if (layer == nullptr || layer.use_count() > 1) return;
+    auto surface = std::move(layer->surface);
+    layer.reset();
+    if (surface == nullptr) return;
+    auto bytes = surface->imageInfo().computeMinByteSize();
+    if (bytes > budget) return;
+    trim(budget - bytes);
+    auto key = make_key(SkISize::Make(surface->width(), surface->height()));
+    entries.push_front(Entry{key, std::move(surface), bytes});
+    buckets[key].push_back(entries.begin());
+    stats.resident_count++;
+    stats.resident_bytes += bytes;
+}
+
+void SurfacePool::set_budget(size_t budget) {
+    this->budget = budget;
+    trim(budget);
+}
+
+void SurfacePool::clear() {
+    entries.clear();
+    buckets.clear();
+    stats.resident_count = 0;
+    stats.resident_bytes = 0;
+}
+
+void SurfacePool::trim(size_t max_bytes) {
+    while (!entries.empty() && stats.resident_bytes > max_bytes) {
+        erase(std::prev(entries.end()));
+        stats.evictions++;
+    }
+}
+
+void SurfacePool::erase(EntriesList::iterator it) {
+    auto bucket = buckets.find(it->key);
+    auto& list = bucket->second;
+    list.erase(std::find(list.begin(), list.end(), it));
+    if (list.empty()) buckets.erase(bucket);
+    stats.resident_count--;
+    stats.resident_bytes -= it->bytes;
+    entries.erase(it);
+}
+
+}  // namespace aardvark
@@ -0,0 +1,64 @@
+#include "utils/data_source.hpp"
+
+#include <mutex>
+#include <unordered_map>
+
+#include "utils/log.hpp"
+
+namespace aardvark {
+
+// Mappings of the files by paths, mapping is removed when no sources use it
+struct MappedFilesState {
+    std::mutex mutex;
+    std::unordered_map<std::string, std::weak_ptr<FileMapping>> mappings;
+};
+
+MappedFilesState& get_mapped_files_state() {
+    static auto state = MappedFilesState();
+    return state;
+}
+
+struct FileMapping {
+    FileMapping(std::string path, sk_sp<SkData> data)
+        : path(std::move(path)), data(std::move(data)){};
+
+    // Sources release mappings only outside of the lock of the state
+    ~FileMapping() {
+        auto& state = get_mapped_files_state();
+        auto lock = std::lock_guard<std::mutex>(state.mutex);
+        auto it = state.mappings.find(path);
+        // Path can be already mapped again by another source
+        if (it != state.mappings.end() && it->second.expired()) {
+            state.mappings.erase(it);
+        }
+    }
+
+    std::string path;
+    sk_sp<SkData> data;
+};
+
+std::shared_ptr<FileMapping> map_file(const std::string& path) {
+    // Skia maps the file read-only and unmaps it when the data is released
+    auto data = SkData::MakeFromFileName(path.c_str());
+    if (data == nullptr) {
+        Log::error("[MappedFile] Failed to map file {}", path);
+        data = SkData::MakeEmpty();
+    }
+    return std::make_shared<FileMapping>(path, std::move(data));
+}
+
+sk_sp<SkData> MappedFile::get_sk_data() {
+    auto& state = get_mapped_files_state();
+    auto lock = std::lock_guard<std::mutex>(state.mutex);
+    if (mapping == nullptr) {
+        auto& shared = state.mappings[path];
+        mapping = shared.lock();
+        if (mapping == nullptr) {
+            mapping = map_file(path);
+            shared = mapping;
+        }
+    }
+    return mapping->data;
+}
+
+}  // namespace aardvark
@@ -5,23 +5,36 @@
 namespace aardvark {
 
 int EventLoop::set_timeout(Callback cb, int timeout) {
-    auto guard = std::lock_guard<std::mutex>(timers_mutex);
-    id++;
-    // map.emplace() returns a pair of an iterator to the inserted element 
-    // and a bool
-    auto it = timers.emplace(id, boost::asio::steady_timer(io)).first;
-    auto& timer = it->second;
-    timer.expires_after(std::chrono::microseconds(timeout));
-    timer.async_wait([this, id = id, cb](const boost::system::error_code& e) {
-        bool is_cancelled = false;
-        {
-            auto guard = std::lock_guard<std::mutex>(timers_mutex);
-            if (timers.find(id) == timers.end()) is_cancelled = true;
-        }
-        // Do not lock during call, so it can set/clear timeouts
-        if (!is_cancelled) cb();
-    });
-    return id;
+    int timer_id;
+    {
+        auto guard = std::lock_guard<std::mutex>(timers_mutex);
+        id++;
+        timer_id = id;
+        // map.emplace() returns a pair of an iterator to the inserted element 
+        // and a bool
+        auto it = timers.emplace(id, boost::asio::steady_timer(io)).first;
+        auto& timer = it->second;
+        timer.expires_after(std::chrono::microseconds(timeout));
+        timer.async_wait(
+            [this, id = id, cb](const boost::system::error_code& e) {
+                bool is_cancelled = false;
+                {
+                    auto guard = std::lock_guard<std::mutex>(timers_mutex);
+                    auto it = timers.find(id);
+                    if (it == timers.end()) {
+                        is_cancelled = true;
+                    } else {
+                        // Fired timer is removed, so it does not affect
+                        // `get_next_expiry`
+                        timers.erase(it);
+                    }
+                }
+                // Do not lock during call, so it can set/clear timeouts
+                if (!is_cancelled) cb();
+            });
+    }
+    wakeup();
+    return timer_id;
 }
 
 void EventLoop::clear_timeout(int id) {
@@ -37,6 +50,7 @@ int EventLoop::post_callback(Callback callback) {
     auto guard = std::lock_guard<std::mutex>(callbacks_mutex);
     id++;
     callbacks[id] = std::move(callback);
+    wakeup();
     io.post([this, id = id]() {
         Callback cb;
         {
@@ -60,4 +74,20 @@ void EventLoop::cancel_callback(int id) {
     if (it != callbacks.end()) callbacks.erase(it);
 }
 
+std::optional<std::chrono::steady_clock::time_point>
+EventLoop::get_next_expiry() {
+    auto guard = std::lock_guard<std::mutex>(timers_mutex);
+    std::optional<std::chrono::steady_clock::time_point> next = std::nullopt;
+    for (auto& it : timers) {
+        auto expiry = it.second.expiry();
+        if (next == std::nullopt || expiry < next.value()) next = expiry;
+    }
+    return next;
+}
+
+bool EventLoop::has_pending_callbacks() {
+    auto guard = std::lock_guard<std::mutex>(callbacks_mutex);
+    return !callbacks.empty();
+}
+
 } // namespace aardvark
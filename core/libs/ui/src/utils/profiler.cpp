@@ -0,0 +1,152 @@
+#include "utils/profiler.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace aardvark {
+
+enum class ProfilerRecordType : int { phase, counter };
+
+// Fields are atomic, so records can be read while they are being overwritten.
+// Sequence is odd while the record is being written, and is `2 * (index + 1)`
+// after the record with the index is written.
+struct ProfilerRecord {
+    std::atomic<uint64_t> sequence{0};
+    std::atomic<int> type{0};
+    std::atomic<const char*> name{nullptr};
+    std::atomic<uint32_t> thread_id{0};
+    std::atomic<int64_t> time{0};
+    // Duration of the phase or value of the counter
+    std::atomic<int64_t> value{0};
+};
+
+struct ProfilerRecordData {
+    ProfilerRecordType type;
+    const char* name;
+    uint32_t thread_id;
+    int64_t time;
+    int64_t value;
+};
+
+std::atomic<bool> profiler_enabled{false};
+std::atomic<uint64_t> profiler_head{0};
+std::unique_ptr<ProfilerRecord[]> profiler_records;
+std::once_flag profiler_alloc_flag;
+const auto profiler_start = std::chrono::steady_clock::now();
+
+uint32_t current_thread_id() {
+    thread_local auto id = static_cast<uint32_t>(
+        std::hash<std::thread::id>()(std::this_thread::get_id()));
+    return id;
+}
+
+void write_profiler_record(
+    ProfilerRecordType type, const char* name, int64_t time, int64_t value) {
+    auto index = profiler_head.fetch_add(1, std::memory_order_relaxed);
+    auto& record = profiler_records[index % Profiler::CAPACITY];
+    record.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    record.type.store(static_cast<int>(type), std::memory_order_relaxed);
+    record.name.store(name, std::memory_order_relaxed);
+    record.thread_id.store(current_thread_id(), std::memory_order_relaxed);
+    record.time.store(time, std::memory_order_relaxed);
+    record.value.store(value, std::memory_order_relaxed);
+    record.sequence.store(2 * (index + 1), std::memory_order_release);
+}
+
+// Reads record with the index, returns `false` if it was overwritten or is
+// being written right now.
+bool read_profiler_record(uint64_t index, ProfilerRecordData* data) {
+    auto& record = profiler_records[index % Profiler::CAPACITY];
+    auto sequence = 2 * (index + 1);
+    if (record.sequence.load(std::memory_order_acquire) != sequence) {
+        return false;
+    }
+    data->type = static_cast<ProfilerRecordType>(
+        record.type.load(std::memory_order_relaxed));
+    data->name = record.name.load(std::memory_order_relaxed);
+    data->thread_id = record.thread_id.load(std::memory_order_relaxed);
+    data->time = record.time.load(std::memory_order_relaxed);
+    data->value = record.value.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return record.sequence.load(std::memory_order_relaxed) == sequence;
+}
+
+void Profiler::enable() {
+    std::call_once(profiler_alloc_flag, []() {
+        profiler_records = std::make_unique<ProfilerRecord[]>(CAPACITY);
+    });
+    profiler_enabled = true;
+}
+
+void Profiler::disable() { profiler_enabled = false; }
+
+bool Profiler::is_enabled() {
+    return profiler_enabled.load(std::memory_order_relaxed);
+}
+
+void Profiler::clear() {
+    if (profiler_records == nullptr) return;
+    for (auto i = 0; i < CAPACITY; i++) {
+        profiler_records[i].sequence.store(0, std::memory_order_relaxed);
+    }
+    profiler_head = 0;
+}
+
+int64_t Profiler::now() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now() - profiler_start)
+        .count();
+}
+
+void Profiler::record_phase(const char* name, int64_t start, int64_t end) {
+    if (!is_enabled()) return;
+    write_profiler_record(ProfilerRecordType::phase, name, start, end - start);
+}
+
+void Profiler::record_counter(const char* name, int64_t value) {
+    if (!is_enabled()) return;
+    write_profiler_record(ProfilerRecordType::counter, name, now(), value);
+}
+
+std::string Profiler::get_chrome_trace() {
+    std::ostringstream out;
+    out << "{\"traceEvents\":[";
+    if (profiler_records != nullptr) {
+        auto head = profiler_head.load(std::memory_order_acquire);
+        auto first = head > CAPACITY ? head - CAPACITY : 0;
+        auto is_first = true;
+        ProfilerRecordData data;
+        for (auto index = first; index < head; index++) {
+            if (!read_profiler_record(index, &data)) continue;
+            if (!is_first) out << ",";
+            is_first = false;
+            out << "{\"name\":\"" << data.name << "\",\"cat\":\"aardvark\","
+                << "\"pid\":1,\"tid\":" << data.thread_id
+                << ",\"ts\":" << data.time;
+            if (data.type == ProfilerRecordType::phase) {
+                out << ",\"ph\":\"X\",\"dur\":" << data.value << "}";
+            } else {
+                out << ",\"ph\":\"C\",\"args\":{\"value\":" << data.value
+                    << "}}";
+            }
+        }
+    }
+    out << "],\"displayTimeUnit\":\"ms\"}";
+    return out.str();
+}
+
+bool Profiler::save_chrome_trace(const std::string& path) {
+    std::ofstream file(path);
+    if (!file) return false;
+    file << get_chrome_trace();
+    return file.good();
+}
+
+}  // namespace aardvark
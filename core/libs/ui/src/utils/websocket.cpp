@@ -4,16 +4,13 @@ namespace aardvark {
 
 void Websocket::open() {
     state = WebsocketState::connecting;
-    resolver.async_resolve(
-        host.c_str(), port.c_str(),
-        beast::bind_front_handler(&Websocket::on_resolve, shared_from_this()));
+    resolver.async_resolve(host.c_str(), port.c_str(),
+                           bind(&Websocket::on_resolve));
 }
 
 void Websocket::send(std::string message) {
     if (state == WebsocketState::open) {
-        ws.async_write(asio::buffer(message),
-                       beast::bind_front_handler(&Websocket::on_write,
-                                                 shared_from_this()));
+        ws.async_write(asio::buffer(message), bind(&Websocket::on_write));
     }
 }
 
@@ -26,34 +23,29 @@ void Websocket::close() {
     } else if (state == WebsocketState::open) {
         state = WebsocketState::closing;
         ws.async_close(beast::websocket::close_code::normal,
-                       beast::bind_front_handler(&Websocket::on_close,
-                                                 shared_from_this()));
+                       bind(&Websocket::on_close));
     }
 }
 
 void Websocket::on_resolve(beast::error_code error,
                            asio::ip::tcp::resolver::results_type results) {
     if (error) return error_signal("Resolve error. " + error.message());
-    beast::get_lowest_layer(ws).async_connect(
-        results,
-        beast::bind_front_handler(&Websocket::on_connect, shared_from_this()));
+    beast::get_lowest_layer(ws).async_connect(results,
+                                              bind(&Websocket::on_connect));
 }
 
 void Websocket::on_connect(
     beast::error_code error,
     asio::ip::tcp::resolver::results_type::endpoint_type) {
     if (error) return error_signal("Connect error. " + error.message());
-    ws.async_handshake(host, "/",
-                       beast::bind_front_handler(&Websocket::on_handshake,
-                                                 shared_from_this()));
+    ws.async_handshake(host, "/", bind(&Websocket::on_handshake));
 }
 
 void Websocket::on_handshake(beast::error_code error) {
     if (error) return error_signal("Handshake error. " + error.message());
     state = WebsocketState::open;
     open_signal();
-    ws.async_read(buffer, beast::bind_front_handler(&Websocket::on_read,
-                                                    shared_from_this()));
+    ws.async_read(buffer, bind(&Websocket::on_read));
 }
 
 void Websocket::on_read(beast::error_code error,
@@ -61,8 +53,7 @@ void Websocket::on_read(beast::error_code error,
     if (error) return error_signal("Read error. " + error.message());
     message_signal(beast::buffers_to_string(buffer.data()));
     buffer.clear();
-    ws.async_read(buffer, beast::bind_front_handler(&Websocket::on_read,
-                                                    shared_from_this()));
+    ws.async_read(buffer, bind(&Websocket::on_read));
 }
 
 void Websocket::on_write(beast::error_code error,
@@ -0,0 +1,106 @@
+#include "utils/work_stealing_pool.hpp"
+
+namespace aardvark {
+
+int WorkStealingPool::default_threads() {
+    auto cores = static_cast<int>(std::thread::hardware_concurrency());
+    return cores > 1 ? cores - 1 : 1;
+}
+
+WorkStealingPool::WorkStealingPool(int threads) {
+    // Worker 0 is the calling thread
+    for (auto i = 0; i <= threads; i++) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    for (auto i = 1; i <= threads; i++) {
+        this->threads.emplace_back([this, i]() { thread_main(i); });
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        auto lock = std::lock_guard<std::mutex>(mutex);
+        stopped = true;
+    }
+    start_condition.notify_all();
+    for (auto& thread : threads) thread.join();
+}
+
+void WorkStealingPool::parallel_for(
+    int count, const std::function<void(int)>& task) {
+    if (count == 0) return;
+    {
+        auto lock = std::lock_guard<std::mutex>(mutex);
+        // Set before the tasks are queued, because threads that are still
+        // running after the previous batch can take them right away
+        current_task = &task;
+        remaining_tasks = count;
+        // Tasks are distributed between workers in contiguous ranges
+        auto workers_count = static_cast<int>(workers.size());
+        for (auto i = 0; i < count; i++) {
+            auto& worker = workers[i * workers_count / count];
+            auto worker_lock = std::lock_guard<std::mutex>(worker->mutex);
+            worker->tasks.push_back(i);
+        }
+        generation++;
+    }
+    start_condition.notify_all();
+    run_tasks(0);
+    auto lock = std::unique_lock<std::mutex>(mutex);
+    done_condition.wait(lock, [this]() { return remaining_tasks == 0; });
+    current_task = nullptr;
+}
+
+void WorkStealingPool::thread_main(int worker_index) {
+    auto seen_generation = 0;
+    while (true) {
+        {
+            auto lock = std::unique_lock<std::mutex>(mutex);
+            start_condition.wait(lock, [&]() {
+                return stopped || generation != seen_generation;
+            });
+            if (stopped) return;
+            seen_generation = generation;
+        }
+        run_tasks(worker_index);
+    }
+}
+
+void WorkStealingPool::run_tasks(int worker_index) {
+    auto task_index = 0;
+    while (take_task(worker_index, &task_index)) {
+        (*current_task)(task_index);
+        if (--remaining_tasks == 0) {
+            // Lock prevents notification from being lost between the check
+            // of the predicate and the wait in `parallel_for`
+            auto lock = std::lock_guard<std::mutex>(mutex);
+            done_condition.notify_all();
+        }
+    }
+}
+
+bool WorkStealingPool::take_task(int worker_index, int* task_index) {
+    // Own tasks are taken from the back, stolen tasks from the front
+    {
+        auto& worker = workers[worker_index];
+        auto lock = std::lock_guard<std::mutex>(worker->mutex);
+        if (!worker->tasks.empty()) {
+            *task_index = worker->tasks.back();
+            worker->tasks.pop_back();
+            return true;
+        }
+    }
+    auto workers_count = static_cast<int>(workers.size());
+    for (auto i = 1; i < workers_count; i++) {
+        auto& victim = workers[(worker_index + i) % workers_count];
+        auto lock = std::lock_guard<std::mutex>(victim->mutex);
+        if (!victim->tasks.empty()) {
+            *task_index = victim->tasks.front();
+            victim->tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace aardvark
@@ -0,0 +1,70 @@
+#include <Catch2/catch.hpp>
+#include <aardvark/animation.hpp>
+
+using namespace aardvark;
+
+TEST_CASE("Animation", "[animation]") {
+    SECTION("timing animation reaches end value after duration") {
+        auto options = AnimationOptions();
+        options.to = 100;
+        options.duration = 200;
+        options.easing = AnimationEasing::linear;
+        auto animation = Animation(options, 0 /* from */);
+        REQUIRE(animation.value_at(0) == 0);
+        REQUIRE(animation.value_at(100) == Approx(50));
+        REQUIRE(!animation.is_done);
+        REQUIRE(animation.value_at(250) == 100);
+        REQUIRE(animation.is_done);
+    }
+
+    SECTION("eased timing animation is symmetric") {
+        auto options = AnimationOptions();
+        options.to = 1;
+        options.duration = 100;
+        auto animation = Animation(options, 0 /* from */);
+        REQUIRE(animation.value_at(50) == Approx(0.5));
+        REQUIRE(animation.value_at(25) == Approx(1 - animation.value_at(75)));
+    }
+
+    SECTION("spring animation settles at end value") {
+        auto options = AnimationOptions();
+        options.type = AnimationType::spring;
+        options.to = 1;
+        auto animation = Animation(options, 0 /* from */);
+        REQUIRE(animation.value_at(0) == Approx(0));
+        auto overshoot = false;
+        auto time = 0;
+        while (!animation.is_done && time < 10000) {
+            if (animation.value_at(time) > 1) overshoot = true;
+            time += 16;
+        }
+        REQUIRE(animation.is_done);
+        REQUIRE(overshoot);
+        REQUIRE(animation.value_at(time) == 1);
+    }
+
+    SECTION("critically damped spring does not overshoot") {
+        auto options = AnimationOptions();
+        options.type = AnimationType::spring;
+        options.to = 1;
+        options.damping = 20;
+        auto animation = Animation(options, 0 /* from */);
+        for (auto time = 0; !animation.is_done; time += 16) {
+            REQUIRE(animation.value_at(time) <= 1);
+        }
+    }
+
+    SECTION("decay animation slows down and stops") {
+        auto options = AnimationOptions();
+        options.type = AnimationType::decay;
+        options.velocity = 1000;
+        auto animation = Animation(options, 0 /* from */);
+        auto first = animation.value_at(16);
+        auto second = animation.value_at(32) - first;
+        REQUIRE(first > second);
+        auto time = 0;
+        while (!animation.is_done) animation.value_at(time += 16);
+        // Distance is velocity divided by the rate of decay
+        REQUIRE(animation.value_at(time) == Approx(500).epsilon(0.001));
+    }
+}
@@ -52,4 +52,15 @@ TEST_CASE("BoxConstraints", "[box_constraints]") {
         REQUIRE(loose.min_height == 0);
         REQUIRE(loose.max_height == 20);
     }
+
+    SECTION("is_equal") {
+        auto a = BoxConstraints{/* min_width */ 10,
+                                /* max_width */ 20,
+                                /* min_height */ 30,
+                                /* max_height */ 40};
+        auto b = a;
+        REQUIRE(BoxConstraints::is_equal(a, b));
+        b.max_height = 50;
+        REQUIRE(!BoxConstraints::is_equal(a, b));
+    }
 }
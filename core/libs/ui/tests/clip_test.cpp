@@ -0,0 +1,62 @@
+#include <Catch2/catch.hpp>
+#include <aardvark/clip.hpp>
+
+using namespace aardvark;
+
+TEST_CASE("Clip", "[clip]") {
+    auto rect = Clip::make_rect(SkRect::MakeWH(100, 100));
+    auto rrect = Clip::make_rrect(
+        SkRRect::MakeRectXY(SkRect::MakeWH(100, 100), 20, 20));
+
+    SECTION("detects rects and rounded rects in paths") {
+        SkPath rect_path;
+        rect_path.addRect(0, 0, 10, 10);
+        REQUIRE(Clip(rect_path).get_type() == Clip::Type::rect);
+        SkPath rrect_path;
+        rrect_path.addRRect(
+            SkRRect::MakeRectXY(SkRect::MakeWH(10, 10), 2, 2));
+        REQUIRE(Clip(rrect_path).get_type() == Clip::Type::rrect);
+        SkPath circle_path;
+        circle_path.addCircle(5, 5, 5);
+        REQUIRE(Clip(circle_path).get_type() == Clip::Type::rrect);
+    }
+
+    SECTION("intersects rects analytically") {
+        auto res = rect.intersect(
+            Clip::make_rect(SkRect::MakeXYWH(50, 50, 100, 100)));
+        REQUIRE(res.get_type() == Clip::Type::rect);
+        REQUIRE(res.get_bounds() == SkRect::MakeXYWH(50, 50, 50, 50));
+
+        auto empty = rect.intersect(
+            Clip::make_rect(SkRect::MakeXYWH(200, 200, 10, 10)));
+        REQUIRE(empty.get_bounds().isEmpty());
+    }
+
+    SECTION("keeps rounded rect inside of rect") {
+        auto outer = Clip::make_rect(SkRect::MakeXYWH(-10, -10, 200, 200));
+        REQUIRE(outer.intersect(rrect).get_type() == Clip::Type::rrect);
+        REQUIRE(rrect.intersect(outer).get_type() == Clip::Type::rrect);
+        auto inner = Clip::make_rect(SkRect::MakeXYWH(40, 40, 10, 10));
+        REQUIRE(rrect.intersect(inner).get_type() == Clip::Type::rect);
+    }
+
+    SECTION("offsets and transforms without converting to path") {
+        REQUIRE(rrect.offset(10, 10).get_bounds() ==
+                SkRect::MakeXYWH(10, 10, 100, 100));
+        REQUIRE(rrect.offset(10, 10).get_type() == Clip::Type::rrect);
+        auto scaled = rect.transform(SkMatrix::MakeScale(2, 2));
+        REQUIRE(scaled.get_type() == Clip::Type::rect);
+        REQUIRE(scaled.get_bounds() == SkRect::MakeWH(200, 200));
+        SkMatrix rotation;
+        rotation.setRotate(45);
+        REQUIRE(rect.transform(rotation).get_type() == Clip::Type::path);
+    }
+
+    SECTION("checks rounded corners when testing points") {
+        REQUIRE(rrect.contains(50, 50));
+        REQUIRE(rrect.contains(50, 1));
+        REQUIRE(!rrect.contains(1, 1));
+        REQUIRE(!rrect.contains(99, 99));
+        REQUIRE(rrect.contains(10, 10));
+    }
+}
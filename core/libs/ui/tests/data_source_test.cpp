@@ -0,0 +1,39 @@
+#include <Catch2/catch.hpp>
+#include <aardvark/utils/data_source.hpp>
+#include <cstdio>
+#include <fstream>
+
+using namespace aardvark;
+
+TEST_CASE("DataSource", "[data_source]") {
+    SECTION("string source returns the same data without copying") {
+        auto src = StringSrc("hello");
+        auto data = src.get_sk_data();
+        REQUIRE(view_data(data) == "hello");
+        REQUIRE(src.get_sk_data()->data() == data->data());
+        REQUIRE(src.get_data() == "hello");
+    }
+
+    SECTION("mapped file shares mapping between sources") {
+        auto path = std::string("adv_ui_tests_mapped_file.txt");
+        {
+            auto stream = std::ofstream(path);
+            stream << "mapped contents";
+        }
+        auto src = MappedFile(path);
+        auto other_src = MappedFile(path);
+        auto data = src.get_sk_data();
+        REQUIRE(view_data(data) == "mapped contents");
+        REQUIRE(other_src.get_sk_data()->data() == data->data());
+        REQUIRE(src.get_data() == File(path).get_data());
+        REQUIRE(src.get_key() == File(path).get_key());
+        std::remove(path.c_str());
+        // Data keeps the mapping alive after the file is removed
+        REQUIRE(view_data(data) == "mapped contents");
+    }
+
+    SECTION("mapped file is empty when it does not exist") {
+        auto src = MappedFile("adv_ui_tests_missing_file.txt");
+        REQUIRE(src.get_sk_data()->size() == 0);
+    }
+}
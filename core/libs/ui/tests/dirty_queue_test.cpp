@@ -0,0 +1,45 @@
+#include <Catch2/catch.hpp>
+#include <aardvark/dirty_queue.hpp>
+#include <aardvark/elements/placeholder.hpp>
+
+using namespace aardvark;
+
+TEST_CASE("DirtyQueue", "[dirty_queue]") {
+    auto a = PlaceholderElement();
+    auto b = PlaceholderElement();
+    auto c = PlaceholderElement();
+
+    SECTION("pops elements ordered by depth") {
+        auto queue = DirtyQueue();
+        queue.push(&a, 3);
+        queue.push(&b, 1);
+        queue.push(&c, 2);
+        REQUIRE(queue.size() == 3);
+        REQUIRE(queue.pop() == &b);
+        REQUIRE(queue.pop() == &c);
+        REQUIRE(queue.pop() == &a);
+        REQUIRE(queue.empty());
+    }
+
+    SECTION("keeps insertion order for same depth") {
+        auto queue = DirtyQueue();
+        queue.push(&c, 1);
+        queue.push(&a, 1);
+        queue.push(&b, 1);
+        REQUIRE(queue.pop() == &c);
+        REQUIRE(queue.pop() == &a);
+        REQUIRE(queue.pop() == &b);
+    }
+
+    SECTION("ignores duplicates") {
+        auto queue = DirtyQueue();
+        queue.push(&a, 1);
+        queue.push(&a, 1);
+        REQUIRE(queue.size() == 1);
+        queue.pop();
+        queue.push(&a, 1);
+        REQUIRE(queue.size() == 1);
+        queue.clear();
+        REQUIRE(queue.empty());
+    }
+}
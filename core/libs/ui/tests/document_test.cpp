@@ -0,0 +1,361 @@
+#include <Catch2/catch.hpp>
+#include <aardvark/document.hpp>
+#include <aardvark/elements/elements.hpp>
+#include <aardvark/pointer_events/hit_tester.hpp>
+
+using namespace aardvark;
+
+// Element that counts how many times it was laid out and painted
+class CountingElement : public Element {
+  public:
+    CountingElement()
+        : Element(
+              /* is_repaint_boundary */ false,
+              /* size_depends_on_parent */ false){};
+
+    Size layout(BoxConstraints constraints) override {
+        layout_count++;
+        return Size{10, 10};
+    };
+
+    float get_intrinsic_height(float width) override {
+        intrinsic_count++;
+        return 10;
+    };
+
+    void paint(bool is_changed) override {
+        paint_count++;
+        auto canvas = document->get_canvas(this);
+        canvas->drawRect(SkRect::MakeWH(size.width, size.height), SkPaint());
+    };
+
+    int layout_count = 0;
+    int intrinsic_count = 0;
+    int paint_count = 0;
+};
+
+TEST_CASE("Document", "[document]") {
+    auto screen = Layer::make_raster_layer(Size{100, 100});
+    auto document = std::make_shared<Document>(screen);
+    document->pixel_ratio = 1;
+
+    SECTION("skips layout of unchanged elements") {
+        auto changed = std::make_shared<CountingElement>();
+        auto unchanged = std::make_shared<CountingElement>();
+        auto root = std::make_shared<StackElement>(
+            std::vector<std::shared_ptr<Element>>{changed, unchanged});
+        document->set_root(root);
+        document->render();
+        REQUIRE(changed->layout_count == 1);
+        REQUIRE(unchanged->layout_count == 1);
+
+        changed->change();
+        document->render();
+        REQUIRE(changed->layout_count == 2);
+        REQUIRE(unchanged->layout_count == 1);
+        REQUIRE(unchanged->size == Size{10, 10});
+        REQUIRE(document->last_frame_counters.layouts_skipped == 1);
+    }
+
+    SECTION("performs layout when constraints are changed") {
+        auto counting = std::make_shared<CountingElement>();
+        auto sized = std::make_shared<SizedElement>(
+            counting, SizeConstraints::exact(Value::abs(20), Value::abs(20)));
+        document->set_root(std::make_shared<StackElement>(
+            std::vector<std::shared_ptr<Element>>{sized}));
+        document->render();
+        REQUIRE(counting->layout_count == 1);
+
+        auto constraints =
+            SizeConstraints::exact(Value::abs(30), Value::abs(30));
+        sized->set_size_constraints(constraints);
+        document->render();
+        REQUIRE(counting->layout_count == 2);
+    }
+
+    SECTION("updates positions of children inside of background") {
+        auto sized = std::make_shared<SizedElement>(
+            std::make_shared<CountingElement>(),
+            SizeConstraints::exact(Value::abs(20), Value::abs(20)));
+        auto next = std::make_shared<CountingElement>();
+        auto row = std::make_shared<FlexElement>(
+            std::vector<std::shared_ptr<Element>>{sized, next},
+            FlexDirection::row,
+            FlexJustify::start,
+            FlexAlign::start);
+        document->set_root(std::make_shared<StackElement>(
+            std::vector<std::shared_ptr<Element>>{
+                std::make_shared<BackgroundElement>(row, Color::black)}));
+        document->render();
+        REQUIRE(next->abs_position == Position{20, 0});
+
+        sized->set_size_constraints(
+            SizeConstraints::exact(Value::abs(30), Value::abs(20)));
+        document->render();
+        REQUIRE(next->abs_position == Position{30, 0});
+    }
+
+    SECTION("updates depth of children inside of background and overflow") {
+        auto inner = std::make_shared<CountingElement>();
+        auto overflow = std::make_shared<OverflowElement>(
+            inner,
+            OverflowConstraint::original,
+            OverflowConstraint::original);
+        auto background =
+            std::make_shared<BackgroundElement>(nullptr, Color::black);
+        auto root = std::make_shared<StackElement>(
+            std::vector<std::shared_ptr<Element>>{background});
+        document->set_root(root);
+        document->render();
+
+        // Attached subtree gets depth during its first layout
+        background->append_child(overflow);
+        document->render();
+        REQUIRE(overflow->depth == 2);
+        REQUIRE(inner->depth == 3);
+    }
+
+    SECTION("updates hit test index after relayout without repaint") {
+        auto sized = std::make_shared<SizedElement>(
+            std::make_shared<CountingElement>(),
+            SizeConstraints::exact(Value::abs(20), Value::abs(20)));
+        auto responder = std::make_shared<ResponderElement>(
+            std::make_shared<CountingElement>(),
+            HitTestMode::Absorb,
+            nullptr);
+        auto row = std::make_shared<FlexElement>(
+            std::vector<std::shared_ptr<Element>>{
+                std::make_shared<BackgroundElement>(
+                    sized,
+                    Color::black,
+                    /* after */ false,
+                    /* is_repaint_boundary */ true),
+                responder},
+            FlexDirection::row,
+            FlexJustify::start,
+            FlexAlign::start);
+        document->set_root(std::make_shared<StackElement>(
+            std::vector<std::shared_ptr<Element>>{row}));
+        document->render();
+        auto hit_tester = HitTester(document.get());
+        REQUIRE(hit_tester.test(25, 5).size() == 1);
+
+        // Change inside of the nested boundary moves element of the parent one
+        sized->set_size_constraints(
+            SizeConstraints::exact(Value::abs(30), Value::abs(20)));
+        document->partial_relayout(sized.get());
+        REQUIRE(hit_tester.test(25, 5).empty());
+        auto hit = hit_tester.test(35, 5);
+        REQUIRE(hit.size() == 1);
+        REQUIRE(hit[0].lock() == responder);
+    }
+
+    SECTION("passes pointer events to the closest hit ancestor") {
+        auto inner = std::make_shared<ResponderElement>(
+            std::make_shared<CountingElement>(),
+            HitTestMode::PassToParent,
+            nullptr,
+            /* is_repaint_boundary */ true);
+        auto sibling = std::make_shared<ResponderElement>(
+            std::make_shared<CountingElement>(),
+            HitTestMode::PassThrough,
+            nullptr);
+        auto outer = std::make_shared<ResponderElement>(
+            std::make_shared<StackElement>(
+                std::vector<std::shared_ptr<Element>>{sibling, inner}),
+            HitTestMode::PassToParent,
+            nullptr);
+        document->set_root(std::make_shared<StackElement>(
+            std::vector<std::shared_ptr<Element>>{outer}));
+        document->render();
+
+        // Sibling is under the pointer, but it is not a parent of the inner
+        auto hit = HitTester(document.get()).test(5, 5);
+        REQUIRE(hit.size() == 2);
+        REQUIRE(hit[0].lock() == inner);
+        REQUIRE(hit[1].lock() == outer);
+    }
+
+    SECTION("caches intrinsic size until element is changed") {
+        auto counting = std::make_shared<CountingElement>();
+        auto other = std::make_shared<CountingElement>();
+        auto row = std::make_shared<FlexElement>(
+            std::vector<std::shared_ptr<Element>>{counting, other},
+            FlexDirection::row,
+            FlexJustify::start,
+            FlexAlign::center);
+        auto root = std::make_shared<IntrinsicHeightElement>(row);
+        document->set_root(std::make_shared<StackElement>(
+            std::vector<std::shared_ptr<Element>>{root}));
+        document->render();
+        REQUIRE(counting->intrinsic_count == 1);
+        REQUIRE(root->query_intrinsic_height(100) == 10);
+        REQUIRE(counting->intrinsic_count == 1);
+
+        // Change of the element invalidates intrinsic size of its ancestors
+        // and causes relayout of the element that used it
+        counting->change();
+        document->render();
+        REQUIRE(counting->intrinsic_count == 2);
+        REQUIRE(other->intrinsic_count == 1);
+        REQUIRE(row->intrinsic_queried == false);
+    }
+
+    SECTION("lays out independent boundaries in parallel") {
+        document->parallel_layout = true;
+        auto counting_elems = std::vector<std::shared_ptr<CountingElement>>();
+        auto children = std::vector<std::shared_ptr<Element>>();
+        for (auto i = 0; i < 8; i++) {
+            auto counting = std::make_shared<CountingElement>();
+            counting_elems.push_back(counting);
+            // Tight constraints make counting elements relayout boundaries
+            children.push_back(std::make_shared<SizedElement>(
+                counting,
+                SizeConstraints::exact(Value::abs(10), Value::abs(10))));
+        }
+        document->set_root(std::make_shared<StackElement>(children));
+        document->render();
+
+        for (auto& counting : counting_elems) counting->change();
+        document->render();
+        for (auto& counting : counting_elems) {
+            REQUIRE(counting->layout_count == 2);
+            REQUIRE(counting->size == Size{10, 10});
+        }
+        REQUIRE(document->last_frame_counters.relayout_boundaries == 8);
+        REQUIRE(document->last_frame_counters.elements_laid_out == 8);
+    }
+
+    SECTION("replays display lists of unchanged elements") {
+        auto changed = std::make_shared<CountingElement>();
+        auto unchanged = std::make_shared<CountingElement>();
+        auto root = std::make_shared<StackElement>(
+            std::vector<std::shared_ptr<Element>>{
+                std::make_shared<SizedElement>(
+                    changed,
+                    SizeConstraints::exact(Value::abs(10), Value::abs(10))),
+                std::make_shared<SizedElement>(
+                    unchanged,
+                    SizeConstraints::exact(Value::abs(10), Value::abs(10)))});
+        document->set_root(root);
+        document->render();
+        REQUIRE(changed->paint_count == 1);
+        REQUIRE(unchanged->paint_count == 1);
+
+        changed->change();
+        document->render();
+        REQUIRE(changed->paint_count == 2);
+        REQUIRE(unchanged->paint_count == 1);
+        REQUIRE(document->last_frame_counters.display_lists_replayed == 1);
+
+        // Layers are rasterized again without painting
+        document->set_pixel_ratio(2);
+        document->render();
+        REQUIRE(root->size == Size{50, 50});
+        REQUIRE(changed->paint_count == 2);
+        REQUIRE(unchanged->paint_count == 1);
+        REQUIRE(document->last_frame_counters.elements_painted == 0);
+        REQUIRE(document->last_frame_counters.display_lists_replayed > 0);
+    }
+
+    SECTION("repaints elements resized by the change of pixel ratio") {
+        auto fixed = std::make_shared<CountingElement>();
+        auto stretched = std::make_shared<SizedElement>(
+            std::make_shared<CountingElement>(),
+            SizeConstraints::exact(Value::rel(0.5), Value::abs(10)));
+        auto root = std::make_shared<StackElement>(
+            std::vector<std::shared_ptr<Element>>{
+                std::make_shared<SizedElement>(
+                    fixed,
+                    SizeConstraints::exact(Value::abs(10), Value::abs(10))),
+                stretched});
+        document->set_root(root);
+        document->render();
+        REQUIRE(stretched->size == Size{50, 10});
+
+        document->set_pixel_ratio(2);
+        document->render();
+        REQUIRE(root->size == Size{50, 50});
+        REQUIRE(stretched->size == Size{25, 10});
+        // Root and the resized element
+        REQUIRE(document->last_frame_counters.elements_painted == 2);
+        REQUIRE(fixed->layout_count == 1);
+        REQUIRE(fixed->paint_count == 1);
+    }
+
+    SECTION("promotes often changed small elements to repaint boundaries") {
+        document->repaint_boundary_tuning.promote_min_changes = 2;
+        auto small = std::make_shared<CountingElement>();
+        auto root = std::make_shared<StackElement>(
+            std::vector<std::shared_ptr<Element>>{
+                std::make_shared<BackgroundElement>(nullptr, Color::black),
+                std::make_shared<SizedElement>(
+                    small,
+                    SizeConstraints::exact(Value::abs(10), Value::abs(10)))});
+        document->set_root(root);
+        document->render();
+        REQUIRE(!small->is_repaint_boundary);
+
+        for (auto i = 0; i < 4; i++) {
+            small->change();
+            document->render();
+        }
+        REQUIRE(small->is_repaint_boundary);
+        REQUIRE(document->repaint_boundary_stats.promotions == 1);
+        REQUIRE(document->repaint_boundary_stats.promoted == 1);
+    }
+
+    SECTION("demotes boundaries that are repainted with their parent") {
+        document->repaint_boundary_tuning.demote_min_repaints = 2;
+        auto boundary = std::make_shared<BackgroundElement>(
+            nullptr,
+            Color::black,
+            /* after */ false,
+            /* is_repaint_boundary */ true);
+        auto root = std::make_shared<StackElement>(
+            std::vector<std::shared_ptr<Element>>{boundary});
+        document->set_root(root);
+        document->render();
+
+        for (auto i = 0; i < 4; i++) {
+            root->change();
+            document->render();
+        }
+        REQUIRE(!boundary->is_repaint_boundary);
+        REQUIRE(document->repaint_boundary_stats.demotions == 1);
+        REQUIRE(document->repaint_boundary_stats.layer_bytes_saved ==
+                100 * 100 * 4);
+    }
+
+    SECTION("animates compose properties without repaint") {
+        auto animated = std::make_shared<CountingElement>();
+        auto root = std::make_shared<StackElement>(
+            std::vector<std::shared_ptr<Element>>{animated});
+        document->set_root(root);
+        document->render();
+
+        auto options = AnimationOptions();
+        options.to = 0.5;
+        options.duration = 0;
+        auto finished = std::optional<bool>();
+        document->start_animation(
+            animated, AnimatedProperty::opacity, options,
+            [&](bool value) { finished = value; });
+        REQUIRE(animated->is_repaint_boundary);
+        document->render();
+        REQUIRE(animated->paint_count == 2);
+        REQUIRE(animated->layer_tree->get_compose_opacity() == 0.5);
+        REQUIRE(finished == true);
+
+        options.to = 10;
+        options.duration = 1000;
+        auto id = document->start_animation(
+            animated, AnimatedProperty::translate_left, options,
+            [&](bool value) { finished = value; });
+        document->render();
+        REQUIRE(document->last_frame_counters.elements_painted == 0);
+        REQUIRE(!document->damage_rects.empty());
+        document->stop_animation(id);
+        REQUIRE(finished == false);
+    }
+}
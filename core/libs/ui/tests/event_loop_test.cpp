@@ -1,5 +1,6 @@
 #include <aardvark/utils/event_loop.hpp>
 #include <iostream>
+#include <thread>
 
 #include "Catch2/catch.hpp"
 
@@ -53,4 +54,24 @@ TEST_CASE("EventLoop", "[event_loop]") {
         REQUIRE(cb1_is_called);
         REQUIRE(!cb2_is_called);
     }
+
+    SECTION("tracks pending io") {
+        auto loop = EventLoop();
+
+        auto handler_is_called = false;
+        auto timer = boost::asio::steady_timer(loop.io);
+        timer.expires_after(std::chrono::milliseconds(5));
+        timer.async_wait(
+            loop.track_io([&](const boost::system::error_code& error) {
+                handler_is_called = true;
+            }));
+
+        REQUIRE(loop.has_pending_io());
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        loop.poll();
+
+        REQUIRE(handler_is_called);
+        REQUIRE(!loop.has_pending_io());
+    }
 }
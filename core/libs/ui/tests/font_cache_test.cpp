@@ -0,0 +1,59 @@
+#include <Catch2/catch.hpp>
+#include <aardvark/elements/text.hpp>
+#include <aardvark/inline_layout/font_cache.hpp>
+#include <thread>
+#include <vector>
+
+using namespace aardvark;
+using namespace aardvark::inline_layout;
+
+TEST_CASE("FontCache", "[font_cache]") {
+    FontCache::clear();
+    auto style = SkFontStyle::Normal();
+
+    SECTION("returns same font for same properties") {
+        auto& font = FontCache::get_font("PT Sans", style, 16);
+        auto& same_font = FontCache::get_font("PT Sans", style, 16);
+        auto& other_size = FontCache::get_font("PT Sans", style, 20);
+        REQUIRE(&font == &same_font);
+        REQUIRE(&font != &other_size);
+        REQUIRE(font.font.getSize() == 16);
+        REQUIRE(font.metrics.height > 0);
+        auto stats = FontCache::get_stats();
+        REQUIRE(stats.hits == 1);
+        REQUIRE(stats.misses == 2);
+        // Typeface is shared by fonts of different sizes
+        REQUIRE(stats.typefaces_loaded == 1);
+    }
+
+    SECTION("falls back when family is not available") {
+        auto& font = FontCache::get_font("No Such Family, Other", style, 16);
+        REQUIRE(font.font.getTypeface() != nullptr);
+    }
+
+    SECTION("is used by text style") {
+        auto text_style = TextStyle();
+        text_style.font_size = 12;
+        text_style.to_sk_font();
+        text_style.get_metrics();
+        auto stats = FontCache::get_stats();
+        REQUIRE(stats.misses == 1);
+        REQUIRE(stats.hits == 1);
+    }
+
+    SECTION("can be used from multiple threads") {
+        auto fonts = std::vector<const CachedFont*>(4);
+        auto threads = std::vector<std::thread>();
+        for (auto i = 0; i < 4; i++) {
+            threads.emplace_back([&fonts, i, style]() {
+                for (auto size = 10; size < 30; size++) {
+                    FontCache::get_font("PT Sans", style, size);
+                }
+                fonts[i] = &FontCache::get_font("PT Sans", style, 16);
+            });
+        }
+        for (auto& thread : threads) thread.join();
+        for (auto font : fonts) REQUIRE(font == fonts[0]);
+        REQUIRE(FontCache::get_stats().misses == 20);
+    }
+}
@@ -0,0 +1,51 @@
+#include <Catch2/catch.hpp>
+#include <aardvark/pointer_events/hit_test_index.hpp>
+#include <algorithm>
+
+using namespace aardvark;
+
+std::vector<int> query_sorted(HitTestIndex& index, float left, float top) {
+    auto result = std::vector<int>();
+    index.query(SkPoint::Make(left, top), &result);
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+TEST_CASE("HitTestIndex", "[hit_test_index]") {
+    SECTION("finds rects containing the point") {
+        auto index = HitTestIndex();
+        index.build({
+            SkRect::MakeXYWH(0, 0, 100, 100),
+            SkRect::MakeXYWH(50, 50, 100, 100),
+            SkRect::MakeXYWH(200, 200, 10, 10),
+        });
+        REQUIRE(query_sorted(index, 10, 10) == std::vector<int>{0});
+        REQUIRE(query_sorted(index, 75, 75) == std::vector<int>{0, 1});
+        REQUIRE(query_sorted(index, 180, 180).empty());
+        // Edges are included
+        REQUIRE(query_sorted(index, 210, 210) == std::vector<int>{2});
+    }
+
+    SECTION("matches linear search for many rects") {
+        auto rects = std::vector<SkRect>();
+        for (auto i = 0; i < 1000; i++) {
+            rects.push_back(SkRect::MakeXYWH(
+                (i * 37) % 500, (i * 91) % 500, 10 + i % 30, 10 + i % 20));
+        }
+        auto index = HitTestIndex();
+        index.build(rects);
+        REQUIRE(index.size() == 1000);
+        for (auto i = 0; i < 100; i++) {
+            auto point = SkPoint::Make((i * 53) % 520, (i * 29) % 520);
+            auto expected = std::vector<int>();
+            for (auto j = 0; j < rects.size(); j++) {
+                auto& rect = rects[j];
+                if (point.x() >= rect.left() && point.x() <= rect.right() &&
+                    point.y() >= rect.top() && point.y() <= rect.bottom()) {
+                    expected.push_back(j);
+                }
+            }
+            REQUIRE(query_sorted(index, point.x(), point.y()) == expected);
+        }
+    }
+}
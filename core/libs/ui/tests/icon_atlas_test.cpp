@@ -0,0 +1,99 @@
+#include <Catch2/catch.hpp>
+#include <SkSurface.h>
+#include <aardvark/document.hpp>
+#include <aardvark/elements/elements.hpp>
+#include <aardvark/icon_atlas.hpp>
+
+using namespace aardvark;
+
+sk_sp<SkImage> make_icon_image(int width, int height) {
+    auto surface = SkSurface::MakeRasterN32Premul(width, height);
+    surface->getCanvas()->clear(SK_ColorRED);
+    return surface->makeImageSnapshot();
+}
+
+TEST_CASE("IconAtlas", "[icon_atlas]") {
+    // Four icons fit into the page
+    auto atlas = IconAtlas(/* page_size */ 64, /* max_pages */ 1);
+    auto images = std::vector<sk_sp<SkImage>>();
+    for (auto i = 0; i < 5; i++) images.push_back(make_icon_image(30, 30));
+    auto first = atlas.get_icon(images[0], /* frame */ 1);
+    REQUIRE(first != std::nullopt);
+
+    SECTION("returns the same place for the same image") {
+        auto again = atlas.get_icon(images[0], /* frame */ 1);
+        REQUIRE(again->page == first->page);
+        REQUIRE(again->rect == first->rect);
+        REQUIRE(atlas.stats.icons_added == 1);
+    }
+
+    SECTION("places icons without overlapping") {
+        auto second = atlas.get_icon(images[1], /* frame */ 1);
+        REQUIRE(second->rect.width() == 30);
+        REQUIRE(!SkRect::Intersects(first->rect, second->rect));
+    }
+
+    SECTION("does not place big images") {
+        auto big = make_icon_image(IconAtlas::MAX_ICON_SIZE + 1, 10);
+        REQUIRE(atlas.get_icon(big, /* frame */ 1) == std::nullopt);
+    }
+
+    SECTION("evicts icons that are not used in the current frame") {
+        for (auto i = 1; i < 4; i++) atlas.get_icon(images[i], /* frame */ 1);
+        // Icons of the current frame are not evicted
+        REQUIRE(atlas.get_icon(images[4], /* frame */ 1) == std::nullopt);
+        REQUIRE(atlas.stats.repacks == 1);
+        REQUIRE(atlas.stats.evictions == 0);
+
+        atlas.get_icon(images[0], /* frame */ 2);
+        auto icon = atlas.get_icon(images[4], /* frame */ 2);
+        REQUIRE(icon != std::nullopt);
+        REQUIRE(atlas.stats.repacks == 2);
+        REQUIRE(atlas.stats.evictions == 3);
+        REQUIRE(atlas.get_pages_count() == 1);
+        // Icon that was kept is moved to the new page
+        auto kept = atlas.get_icon(images[0], /* frame */ 2);
+        REQUIRE(kept->page == icon->page);
+        REQUIRE(atlas.stats.icons_added == 5);
+    }
+}
+
+TEST_CASE("Document icons", "[icon_atlas]") {
+    auto src = std::make_shared<StringSrc>(
+        "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"24\" "
+        "height=\"24\"><rect id=\"fill\" width=\"24\" height=\"24\" "
+        "fill=\"red\"/></svg>");
+    auto screen = Layer::make_raster_layer(Size{400, 100});
+    auto document = std::make_shared<Document>(screen);
+    document->pixel_ratio = 1;
+    auto icons = std::vector<std::shared_ptr<SvgImageElement>>();
+    auto children = std::vector<std::shared_ptr<Element>>();
+    for (auto i = 0; i < 10; i++) {
+        auto icon = std::make_shared<SvgImageElement>(src, ImageFit::contain);
+        icon->use_icon_atlas = true;
+        icons.push_back(icon);
+        children.push_back(std::make_shared<AlignedElement>(
+            std::make_shared<SizedElement>(
+                icon, SizeConstraints{Value::abs(24), Value::abs(24)}),
+            Alignment::top_left(Value::abs(0), Value::abs(30 * i))));
+    }
+    document->set_root(std::make_shared<StackElement>(children));
+    document->render();
+
+    SECTION("draws icons of the layer in one batch") {
+        auto& counters = document->last_frame_counters;
+        REQUIRE(counters.icons_drawn == 10);
+        REQUIRE(counters.icon_batches == 1);
+        REQUIRE(document->icon_atlas.stats.icons_added == 1);
+    }
+
+    SECTION("keeps batching after repaint") {
+        auto color_map = ColorMap{{"fill", Color{0, 0, 255, 255}}};
+        icons[3]->set_color_map(color_map);
+        document->render();
+        auto& counters = document->last_frame_counters;
+        REQUIRE(counters.icons_drawn == 10);
+        REQUIRE(counters.icon_batches == 1);
+        REQUIRE(document->icon_atlas.stats.icons_added == 2);
+    }
+}
@@ -0,0 +1,233 @@
+#include <Catch2/catch.hpp>
+#include <SkBitmap.h>
+#include <SkStream.h>
+#include <aardvark/document.hpp>
+#include <aardvark/elements/elements.hpp>
+#include <aardvark/image_cache.hpp>
+#include <chrono>
+#include <include/encode/SkPngEncoder.h>
+#include <thread>
+
+using namespace aardvark;
+
+// Red PNG image of 2x2 pixels
+const auto PNG_DATA = std::string(
+    "\x89\x50\x4e\x47\x0d\x0a\x1a\x0a\x00\x00\x00\x0d\x49\x48\x44\x52\x00\x00"
+    "\x00\x02\x00\x00\x00\x02\x08\x02\x00\x00\x00\xfd\xd4\x9a\x73\x00\x00\x00"
+    "\x10\x49\x44\x41\x54\x78\x9c\x63\xf8\xcf\xc0\x00\x44\x0c\x10\x0a\x00\x1f"
+    "\xee\x03\xfd\x8b\x5f\x14\xd4\x00\x00\x00\x00\x49\x45\x4e\x44\xae\x42\x60"
+    "\x82",
+    73);
+
+TEST_CASE("ImageCache", "[image_cache]") {
+    ImageCache::clear();
+    ImageCache::set_budget(ImageCache::DEFAULT_BUDGET);
+    auto src = std::make_shared<StringSrc>(PNG_DATA);
+
+    SECTION("decodes on the calling thread without event loop") {
+        auto image = ImageCache::get_image(src, nullptr, nullptr, nullptr);
+        REQUIRE(image.image != nullptr);
+        REQUIRE(image.image->width() == 2);
+        REQUIRE(image.image->height() == 2);
+        REQUIRE(image.original_size == SkISize::Make(2, 2));
+        auto cached = ImageCache::get_image(src, nullptr, nullptr, nullptr);
+        REQUIRE(cached.image == image.image);
+        auto stats = ImageCache::get_stats();
+        REQUIRE(stats.hits == 1);
+        REQUIRE(stats.misses == 1);
+        REQUIRE(stats.decodes == 1);
+        REQUIRE(stats.bytes > 0);
+    }
+
+    SECTION("decodes in the background once for all requests") {
+        auto loop = EventLoop();
+        auto images = std::vector<sk_sp<SkImage>>();
+        auto callback = [&images](DecodedImage image) {
+            images.push_back(std::move(image.image));
+        };
+        auto first = ImageCache::get_image(src, nullptr, &loop, callback);
+        REQUIRE(first.image == nullptr);
+        auto second = ImageCache::get_image(src, nullptr, &loop, callback);
+        REQUIRE(second.image == nullptr);
+        auto deadline =
+            std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (images.size() < 2 &&
+               std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            loop.io.restart();
+            loop.poll();
+        }
+        REQUIRE(images.size() == 2);
+        REQUIRE(images[0] != nullptr);
+        REQUIRE(images[0] == images[1]);
+        REQUIRE(ImageCache::get_stats().decodes == 1);
+        auto cached = ImageCache::get_image(src, nullptr, &loop, callback);
+        REQUIRE(cached.image == images[0]);
+    }
+
+    SECTION("decodes again for requests that need bigger image") {
+        auto loop = EventLoop();
+        auto small = sk_sp<SkImage>();
+        auto big = sk_sp<SkImage>();
+        ImageCache::get_image(
+            src,
+            [](SkISize original_size) { return SkISize::Make(1, 1); },
+            &loop,
+            [&small](DecodedImage image) { small = std::move(image.image); });
+        // Request can join the decoding of the smaller image
+        ImageCache::get_image(
+            src,
+            [](SkISize original_size) { return SkISize::Make(2, 2); },
+            &loop,
+            [&big](DecodedImage image) { big = std::move(image.image); });
+        auto deadline =
+            std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while ((small == nullptr || big == nullptr) &&
+               std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            loop.io.restart();
+            loop.poll();
+        }
+        REQUIRE(small != nullptr);
+        REQUIRE(big != nullptr);
+        REQUIRE(big->width() == 2);
+        REQUIRE(big->height() == 2);
+        REQUIRE(ImageCache::get_stats().decodes == 2);
+    }
+
+    SECTION("evicts least recently used images over the budget") {
+        auto other_src = std::make_shared<StringSrc>(PNG_DATA);
+        ImageCache::get_image(src, nullptr, nullptr, nullptr);
+        auto image_bytes = ImageCache::get_stats().bytes;
+        ImageCache::set_budget(image_bytes);
+        ImageCache::get_image(other_src, nullptr, nullptr, nullptr);
+        auto stats = ImageCache::get_stats();
+        REQUIRE(stats.evictions == 1);
+        REQUIRE(stats.bytes == image_bytes);
+        ImageCache::get_image(other_src, nullptr, nullptr, nullptr);
+        REQUIRE(ImageCache::get_stats().hits == 1);
+        ImageCache::get_image(src, nullptr, nullptr, nullptr);
+        REQUIRE(ImageCache::get_stats().misses == 3);
+    }
+
+    SECTION("shares images of files with the same path") {
+        auto file = std::make_shared<File>("image.png");
+        auto same_file = std::make_shared<File>("image.png");
+        REQUIRE(file->get_key() == same_file->get_key());
+        REQUIRE(src->get_key().empty());
+    }
+}
+
+std::string encode_png(int width, int height) {
+    auto bitmap = SkBitmap();
+    bitmap.allocN32Pixels(width, height, /* isOpaque */ true);
+    bitmap.eraseColor(SK_ColorBLUE);
+    auto stream = SkDynamicMemoryWStream();
+    SkPngEncoder::Encode(&stream, bitmap.pixmap(), {});
+    auto data = stream.detachAsData();
+    return std::string((const char*)data->data(), data->size());
+}
+
+TEST_CASE("ImageElement", "[image_cache]") {
+    ImageCache::clear();
+    ImageCache::set_budget(ImageCache::DEFAULT_BUDGET);
+    auto src = std::make_shared<StringSrc>(encode_png(1200, 900));
+    auto screen = Layer::make_raster_layer(Size{1200, 900});
+    auto document = std::make_shared<Document>(screen);
+    document->pixel_ratio = 1;
+    auto images = std::vector<std::shared_ptr<ImageElement>>();
+    auto thumbs = std::vector<std::shared_ptr<SizedElement>>();
+    auto children = std::vector<std::shared_ptr<Element>>();
+    for (auto i = 0; i < 10; i++) {
+        auto image = std::make_shared<ImageElement>(src, ImageFit::contain);
+        auto thumb = std::make_shared<SizedElement>(
+            image,
+            SizeConstraints{Value::abs(120), Value::abs(90)});
+        images.push_back(image);
+        thumbs.push_back(thumb);
+        children.push_back(std::make_shared<AlignedElement>(
+            thumb,
+            Alignment::top_left(
+                Value::abs(90 * (i / 5)), Value::abs(120 * (i % 5)))));
+    }
+    document->set_root(std::make_shared<StackElement>(children));
+    document->render();
+    auto thumb_bytes = ImageCache::get_stats().bytes;
+
+    SECTION("decodes images at the painted size") {
+        REQUIRE(images[0]->get_image()->width() == 120);
+        REQUIRE(images[0]->get_image()->height() == 90);
+        REQUIRE(ImageCache::get_stats().decodes == 1);
+        REQUIRE(thumb_bytes == 120 * 90 * 4);
+        ImageCache::clear();
+        auto full = ImageCache::get_image(src, nullptr, nullptr, nullptr);
+        REQUIRE(full.image->width() == 1200);
+        REQUIRE(ImageCache::get_stats().bytes >= thumb_bytes * 100);
+    }
+
+    SECTION("decodes again only when image is enlarged") {
+        auto smaller = SizeConstraints{Value::abs(60), Value::abs(45)};
+        thumbs[0]->set_size_constraints(smaller);
+        document->render();
+        REQUIRE(ImageCache::get_stats().decodes == 1);
+        REQUIRE(images[0]->get_image()->width() == 120);
+
+        auto bigger = SizeConstraints{Value::abs(240), Value::abs(180)};
+        thumbs[0]->set_size_constraints(bigger);
+        document->render();
+        REQUIRE(ImageCache::get_stats().decodes == 2);
+        REQUIRE(images[0]->get_image()->width() == 240);
+        REQUIRE(images[0]->get_image()->height() == 180);
+    }
+}
+
+const auto SVG_DATA = std::string(
+    "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"24\" height=\"24\">"
+    "<rect id=\"fill\" width=\"24\" height=\"24\" fill=\"red\"/></svg>");
+
+TEST_CASE("SvgImageElement", "[image_cache]") {
+    ImageCache::clear();
+    ImageCache::set_budget(ImageCache::DEFAULT_BUDGET);
+    auto src = std::make_shared<StringSrc>(SVG_DATA);
+    auto screen = Layer::make_raster_layer(Size{200, 200});
+    auto document = std::make_shared<Document>(screen);
+    document->pixel_ratio = 2;
+    auto icons = std::vector<std::shared_ptr<SvgImageElement>>();
+    auto children = std::vector<std::shared_ptr<Element>>();
+    for (auto i = 0; i < 2; i++) {
+        auto icon = std::make_shared<SvgImageElement>(src, ImageFit::contain);
+        icon->raster_cache = true;
+        icons.push_back(icon);
+        children.push_back(std::make_shared<AlignedElement>(
+            std::make_shared<SizedElement>(
+                icon, SizeConstraints{Value::abs(48), Value::abs(48)}),
+            Alignment::top_left(Value::abs(0), Value::abs(48 * i))));
+    }
+    document->set_root(std::make_shared<StackElement>(children));
+    document->render();
+
+    SECTION("shares raster between elements with the same source") {
+        auto stats = ImageCache::get_stats();
+        REQUIRE(stats.renders == 1);
+        REQUIRE(stats.hits == 1);
+        REQUIRE(stats.bytes == 96 * 96 * 4);
+    }
+
+    SECTION("renders again only when the inputs are changed") {
+        icons[0]->change();
+        document->render();
+        REQUIRE(ImageCache::get_stats().renders == 1);
+
+        auto color_map = ColorMap{{"fill", Color{0, 0, 255, 255}}};
+        icons[0]->set_color_map(color_map);
+        document->render();
+        REQUIRE(ImageCache::get_stats().renders == 2);
+
+        // Both colored and default variants are rendered at the new size
+        document->pixel_ratio = 1;
+        icons[0]->change();
+        icons[1]->change();
+        document->render();
+        REQUIRE(ImageCache::get_stats().renders == 4);
+    }
+}
@@ -0,0 +1,143 @@
+#include <Catch2/catch.hpp>
+#include <aardvark/document.hpp>
+#include <aardvark/elements/elements.hpp>
+#include <aardvark/inline_layout/decoration_span.hpp>
+#include <aardvark/inline_layout/text_span.hpp>
+
+using namespace aardvark;
+
+TEST_CASE("ParagraphElement", "[paragraph]") {
+    auto screen = Layer::make_raster_layer(Size{200, 1000});
+    auto document = std::make_shared<Document>(screen);
+    document->pixel_ratio = 1;
+    auto style = TextStyle();
+    auto text = std::string("The quick brown fox jumps over the lazy dog. ");
+    auto spans = std::vector<std::shared_ptr<inline_layout::Span>>();
+    auto text_spans = std::vector<std::shared_ptr<inline_layout::TextSpan>>();
+    for (auto i = 0; i < 20; i++) {
+        auto span = std::make_shared<inline_layout::TextSpan>(
+            UnicodeString::fromUTF8(text), style);
+        spans.push_back(span);
+        text_spans.push_back(span);
+    }
+    auto root = std::make_shared<inline_layout::DecorationSpan>(spans);
+    auto paragraph =
+        std::make_shared<ParagraphElement>(root, style.get_metrics());
+    document->set_root(std::make_shared<StackElement>(
+        std::vector<std::shared_ptr<Element>>{paragraph}));
+    document->render();
+    auto& counters = paragraph->last_layout_counters;
+    auto lines = counters.lines_laid_out;
+    auto height = paragraph->size.height;
+    REQUIRE(lines > 2);
+    REQUIRE(counters.lines_reused == 0);
+
+    SECTION("keeps lines before the changed span") {
+        auto new_text = text + text;
+        text_spans.back()->set_text(new_text);
+        paragraph->change();
+        document->render();
+        REQUIRE(counters.lines_reused > 0);
+        REQUIRE(counters.lines_laid_out < lines);
+        REQUIRE(paragraph->size.height > height);
+    }
+
+    SECTION("reuses lines after the changed span") {
+        text_spans.front()->set_text(text);
+        paragraph->change();
+        document->render();
+        REQUIRE(counters.lines_laid_out <= 2);
+        REQUIRE(counters.lines_reused + counters.lines_laid_out == lines);
+        REQUIRE(paragraph->size.height == height);
+    }
+
+    SECTION("continues the last line after appending span") {
+        root->append_child(std::make_shared<inline_layout::TextSpan>(
+            UnicodeString::fromUTF8("end"), style));
+        paragraph->change();
+        document->render();
+        REQUIRE(counters.lines_reused > 0);
+        REQUIRE(counters.lines_reused + counters.lines_laid_out <= lines + 1);
+    }
+
+    SECTION("paints text spans from blobs of the lines") {
+        auto children = 0;
+        paragraph->visit_children(
+            [&children](std::shared_ptr<Element>& child) { children++; });
+        REQUIRE(children == 0);
+        REQUIRE(counters.text_spans_batched >= 20);
+    }
+
+    SECTION("renders elements for decorated spans") {
+        auto decorated = std::make_shared<inline_layout::DecorationSpan>(
+            std::vector<std::shared_ptr<inline_layout::Span>>{
+                std::make_shared<inline_layout::TextSpan>(
+                    UnicodeString::fromUTF8("decorated"), style)},
+            inline_layout::Decoration{Color{255, 0, 0, 255}});
+        root->append_child(decorated);
+        paragraph->change();
+        document->render();
+        auto children = 0;
+        paragraph->visit_children(
+            [&children](std::shared_ptr<Element>& child) { children++; });
+        REQUIRE(children == 1);
+        REQUIRE(counters.elements_rendered == 1);
+    }
+
+    SECTION("lays out all lines when root decoration is changed") {
+        auto decoration = inline_layout::Decoration{Color{255, 0, 0, 255}};
+        root->set_decoration(decoration);
+        paragraph->change();
+        document->render();
+        REQUIRE(counters.lines_reused == 0);
+        REQUIRE(counters.lines_laid_out == lines);
+    }
+
+    SECTION("measures intrinsic height as the height of the lines") {
+        REQUIRE(paragraph->get_intrinsic_height(200) == height);
+        REQUIRE(paragraph->get_intrinsic_height(100) > height);
+    }
+
+    SECTION("keeps layout after intrinsic height is queried") {
+        root->append_child(std::make_shared<inline_layout::DecorationSpan>(
+            std::vector<std::shared_ptr<inline_layout::Span>>{
+                std::make_shared<inline_layout::TextSpan>(
+                    UnicodeString::fromUTF8("decorated"), style)},
+            inline_layout::Decoration{Color{255, 0, 0, 255}}));
+        paragraph->change();
+        document->render();
+        auto laid_out = counters.lines_laid_out + counters.lines_reused;
+        auto laid_out_height = paragraph->size.height;
+
+        // Layout with the same constraints is skipped after the query
+        REQUIRE(paragraph->query_intrinsic_height(100) > laid_out_height);
+        document->render();
+        REQUIRE(counters.lines_laid_out + counters.lines_reused == laid_out);
+        REQUIRE(paragraph->size.height == laid_out_height);
+        auto children = 0;
+        paragraph->visit_children([&](std::shared_ptr<Element>& child) {
+            REQUIRE(child->document == document.get());
+            children++;
+        });
+        REQUIRE(children == 1);
+
+        // Lines are reused from the layout, not from the query
+        text_spans.back()->set_text(text);
+        paragraph->change();
+        document->render();
+        REQUIRE(counters.lines_reused > 0);
+        REQUIRE(paragraph->size.height == laid_out_height);
+    }
+
+    SECTION("lays out all lines when width is changed") {
+        auto stack = std::dynamic_pointer_cast<StackElement>(document->root);
+        auto sized = std::make_shared<SizedElement>(
+            paragraph,
+            SizeConstraints::exact(Value::abs(150), Value::abs(1000)));
+        stack->remove_child(paragraph);
+        stack->append_child(sized);
+        document->render();
+        REQUIRE(counters.lines_reused == 0);
+        REQUIRE(counters.lines_laid_out > lines);
+    }
+}
@@ -0,0 +1,78 @@
+#include <Catch2/catch.hpp>
+#include <aardvark/document.hpp>
+#include <aardvark/elements/elements.hpp>
+
+using namespace aardvark;
+
+PointerEvent make_pointer_event(
+    int timestamp, PointerAction action, float left, float top) {
+    return PointerEvent{
+        timestamp,           // timestamp
+        PointerTool::mouse,  // tool
+        0,                   // pointer_id
+        action,              // action
+        left,                // left
+        top,                 // top
+        -1                   // button
+    };
+}
+
+TEST_CASE("PointerEventManager", "[pointer_event_manager]") {
+    auto screen = Layer::make_raster_layer(Size{100, 100});
+    auto document = std::make_shared<Document>(screen);
+    document->pixel_ratio = 1;
+    document->set_root(std::make_shared<StackElement>(
+        std::vector<std::shared_ptr<Element>>{}));
+    document->render();
+
+    auto frames_requested = 0;
+    document->request_frame_handler = [&]() { frames_requested++; };
+
+    auto events = std::vector<PointerEvent>();
+    auto connection = document->add_pointer_event_handler(
+        [&](const PointerEvent& event) { events.push_back(event); });
+    auto manager = document->pointer_event_manager.get();
+
+    SECTION("coalesces move events until the next frame") {
+        manager->handle_event(
+            make_pointer_event(1, PointerAction::pointer_move, 10, 10));
+        manager->handle_event(
+            make_pointer_event(2, PointerAction::pointer_move, 20, 20));
+        manager->handle_event(
+            make_pointer_event(3, PointerAction::pointer_move, 30, 30));
+        REQUIRE(events.empty());
+        REQUIRE(frames_requested == 1);
+
+        document->render();
+        REQUIRE(events.size() == 1);
+        auto& event = events[0];
+        REQUIRE(event.timestamp == 3);
+        REQUIRE(event.left == 30);
+        REQUIRE(event.coalesced.size() == 3);
+        REQUIRE(event.coalesced[0].timestamp == 1);
+        REQUIRE(event.coalesced[0].left == 10);
+        REQUIRE(event.coalesced[2].timestamp == 3);
+
+        REQUIRE(manager->stats.raw_move_events == 3);
+        REQUIRE(manager->stats.dispatched_move_events == 1);
+        REQUIRE(manager->stats.coalesced_move_events == 2);
+    }
+
+    SECTION("dispatches pending moves before other events") {
+        manager->handle_event(
+            make_pointer_event(1, PointerAction::pointer_move, 10, 10));
+        manager->handle_event(
+            make_pointer_event(2, PointerAction::button_press, 10, 10));
+        REQUIRE(events.size() == 2);
+        REQUIRE(events[0].action == PointerAction::pointer_move);
+        REQUIRE(events[1].action == PointerAction::button_press);
+    }
+
+    SECTION("dispatches moves immediately when coalescing is disabled") {
+        manager->coalesce_move_events = false;
+        manager->handle_event(
+            make_pointer_event(1, PointerAction::pointer_move, 10, 10));
+        REQUIRE(events.size() == 1);
+        REQUIRE(events[0].coalesced.empty());
+    }
+}
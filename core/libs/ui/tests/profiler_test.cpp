@@ -0,0 +1,51 @@
+#include <Catch2/catch.hpp>
+#include <aardvark/utils/profiler.hpp>
+
+using namespace aardvark;
+
+int count_occurrences(const std::string& str, const std::string& substr) {
+    auto count = 0;
+    auto pos = str.find(substr);
+    while (pos != std::string::npos) {
+        count++;
+        pos = str.find(substr, pos + substr.size());
+    }
+    return count;
+}
+
+TEST_CASE("Profiler", "[profiler]") {
+    Profiler::clear();
+
+    SECTION("does not record when disabled") {
+        Profiler::disable();
+        { auto scope = ProfilerScope("phase"); }
+        Profiler::record_counter("counter", 1);
+        REQUIRE(count_occurrences(Profiler::get_chrome_trace(), "\"name\"") ==
+                0);
+    }
+
+    SECTION("records phases and counters") {
+        Profiler::enable();
+        { auto scope = ProfilerScope("phase"); }
+        Profiler::record_counter("counter", 42);
+        Profiler::disable();
+        auto trace = Profiler::get_chrome_trace();
+        REQUIRE(count_occurrences(trace, "\"name\":\"phase\"") == 1);
+        REQUIRE(count_occurrences(trace, "\"ph\":\"X\"") == 1);
+        REQUIRE(count_occurrences(trace, "\"args\":{\"value\":42}") == 1);
+    }
+
+    SECTION("keeps only latest records") {
+        Profiler::enable();
+        for (auto i = 0; i < Profiler::CAPACITY + 10; i++) {
+            Profiler::record_counter("counter", i);
+        }
+        Profiler::disable();
+        auto trace = Profiler::get_chrome_trace();
+        REQUIRE(count_occurrences(trace, "\"name\"") == Profiler::CAPACITY);
+        REQUIRE(count_occurrences(trace, "{\"value\":9}") == 0);
+        REQUIRE(count_occurrences(trace, "{\"value\":10}") == 1);
+    }
+
+    Profiler::clear();
+}
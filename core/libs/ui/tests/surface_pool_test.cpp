@@ -0,0 +1,60 @@
+#include <Catch2/catch.hpp>
+#include <aardvark/surface_pool.hpp>
+
+using namespace aardvark;
+
+TEST_CASE("SurfacePool", "[surface_pool]") {
+    SECTION("rounds sizes up to buckets") {
+        REQUIRE(SurfacePool::bucket_size(Size{10, 32}) ==
+                SkISize::Make(32, 32));
+        REQUIRE(SurfacePool::bucket_size(Size{500, 1000}) ==
+                SkISize::Make(512, 1024));
+        REQUIRE(SurfacePool::bucket_size(Size{520.5, 1030}) ==
+                SkISize::Make(576, 1152));
+        REQUIRE(SurfacePool::bucket_size(Size{33, 257}) ==
+                SkISize::Make(64, 288));
+    }
+
+    SECTION("reuses surfaces of the same bucket") {
+        auto pool = SurfacePool(/* gr_context */ nullptr);
+        auto layer = pool.acquire(Size{100, 100});
+        REQUIRE(pool.stats.misses == 1);
+        REQUIRE(Size::is_equal(layer->size, Size{100, 100}));
+        auto surface = layer->surface.get();
+        pool.release(std::move(layer));
+        REQUIRE(pool.stats.resident_count == 1);
+        REQUIRE(pool.stats.resident_bytes == 128 * 128 * 4);
+
+        auto resized = pool.acquire(Size{110, 105});
+        REQUIRE(pool.stats.hits == 1);
+        REQUIRE(resized->surface.get() == surface);
+        REQUIRE(Size::is_equal(resized->size, Size{110, 105}));
+        REQUIRE(pool.stats.resident_bytes == 0);
+    }
+
+    SECTION("does not reuse referenced layers") {
+        auto pool = SurfacePool(/* gr_context */ nullptr);
+        auto layer = pool.acquire(Size{100, 100});
+        pool.release(layer);
+        REQUIRE(pool.stats.resident_count == 0);
+    }
+
+    SECTION("evicts least recently released surfaces") {
+        auto surface_bytes = 128 * 128 * 4;
+        auto pool = SurfacePool(/* gr_context */ nullptr, surface_bytes * 2);
+        auto a = pool.acquire(Size{128, 128});
+        auto b = pool.acquire(Size{128, 128});
+        auto c = pool.acquire(Size{128, 128});
+        auto c_surface = c->surface.get();
+        pool.release(std::move(a));
+        pool.release(std::move(b));
+        pool.release(std::move(c));
+        REQUIRE(pool.stats.evictions == 1);
+        REQUIRE(pool.stats.resident_bytes == surface_bytes * 2);
+        REQUIRE(pool.acquire(Size{128, 128})->surface.get() == c_surface);
+
+        pool.set_budget(0);
+        REQUIRE(pool.stats.resident_count == 0);
+        REQUIRE(pool.stats.evictions == 2);
+    }
+}
@@ -2,6 +2,8 @@
 #include <aardvark/base_types.hpp>
 #include <aardvark/inline_layout/text_span.hpp>
 #include <aardvark/inline_layout/decoration_span.hpp>
+#include <aardvark/inline_layout/line_breaks.hpp>
+#include <aardvark/inline_layout/shaped_text.hpp>
 #include <aardvark/inline_layout/utils.hpp>
 
 using namespace aardvark;
@@ -326,4 +328,93 @@ TEST_CASE("TextSpan", "[inline][text_span]") {
         REQUIRE(inside_right == 2);
     }
 
+    SECTION("split spans share shaped text") {
+        auto constraints = inline_layout::InlineConstraints{
+            hello_width,  // remaining_width
+            1000,         // total_width
+            0,            // padding_before
+            0             // padding_after
+        };
+        auto res = span->layout(constraints);
+        auto remainder_span =
+            std::dynamic_pointer_cast<inline_layout::TextSpan>(
+                res.remainder_span.value());
+        REQUIRE(&remainder_span->get_shaped_text() == &span->get_shaped_text());
+        REQUIRE(remainder_span->get_shaped_offset() == hello.length());
+    }
+
+    SECTION("split spans share line breaks") {
+        auto constraints = inline_layout::InlineConstraints{
+            hello_width,  // remaining_width
+            1000,         // total_width
+            0,            // padding_before
+            0             // padding_after
+        };
+        auto res = span->layout(constraints);
+        auto created_iterators =
+            inline_layout::LineBreaks::get_created_iterators();
+        auto remainder_span =
+            std::dynamic_pointer_cast<inline_layout::TextSpan>(
+                res.remainder_span.value());
+        auto remainder_res = remainder_span->layout(constraints);
+        REQUIRE(remainder_res.type == inline_layout::InlineLayoutResult::Type::fit);
+        REQUIRE(&remainder_span->get_line_breaks() == &span->get_line_breaks());
+        REQUIRE(remainder_span->get_line_breaks_offset() == hello.length());
+        REQUIRE(
+            inline_layout::LineBreaks::get_created_iterators() ==
+            created_iterators);
+    }
+
+}
+
+TEST_CASE("LineBreaks", "[inline][line_breaks]") {
+    auto text = UnicodeString((UChar*)u"Hello, World!");
+
+    SECTION("finds break positions including start and end") {
+        auto breaks = inline_layout::LineBreaks::find(text);
+        REQUIRE(breaks == std::vector<int>{0, 7, 13});
+    }
+
+    SECTION("reuses pooled iterators") {
+        inline_layout::LineBreaks::find(text);
+        auto created_iterators =
+            inline_layout::LineBreaks::get_created_iterators();
+        for (auto i = 0; i < 10; i++) inline_layout::LineBreaks::find(text);
+        REQUIRE(
+            inline_layout::LineBreaks::get_created_iterators() ==
+            created_iterators);
+    }
+}
+
+TEST_CASE("ShapedText", "[inline][shaped_text]") {
+    auto style = TextStyle();
+    auto font = style.to_sk_font();
+    // Emoji is a single glyph of two code units
+    auto text = UnicodeString((UChar*)u"ab\U0001F600cd");
+    auto shaped = inline_layout::ShapedText(text, font);
+    REQUIRE(shaped.length == 6);
+    REQUIRE(shaped.get_glyph_count() == 5);
+
+    SECTION("measures ranges with prefix sums") {
+        REQUIRE(shaped.get_width(0, 6) == Approx(shaped.offsets[5]));
+        auto ab = UnicodeString((UChar*)u"ab");
+        REQUIRE(
+            shaped.get_width(0, 2) ==
+            Approx(inline_layout::measure_text_width(ab, font)));
+    }
+
+    SECTION("fits text between glyphs") {
+        auto width = 0.0f;
+        auto emoji_end = shaped.get_width(0, 4);
+        REQUIRE(shaped.fit(0, 6, emoji_end - 0.1f, &width) == 2);
+        REQUIRE(shaped.fit(0, 6, emoji_end, &width) == 4);
+        REQUIRE(width == emoji_end);
+        REQUIRE(shaped.fit(0, 6, 10000, &width) == 6);
+    }
+
+    SECTION("does not split surrogate pairs") {
+        REQUIRE(shaped.prev_position(4) == 2);
+        REQUIRE(shaped.next_position(2) == 4);
+        REQUIRE(shaped.find_position(0, 6, shaped.get_width(0, 3)) != 3);
+    }
 }
@@ -0,0 +1,44 @@
+#include <Catch2/catch.hpp>
+#include <aardvark/utils/work_stealing_pool.hpp>
+#include <future>
+
+using namespace aardvark;
+
+TEST_CASE("WorkStealingPool", "[work_stealing_pool]") {
+    auto pool = WorkStealingPool(3);
+    REQUIRE(pool.size() == 4);
+
+    SECTION("runs every task once") {
+        auto counts = std::vector<std::atomic<int>>(1000);
+        pool.parallel_for(1000, [&](int i) { counts[i]++; });
+        for (auto& count : counts) REQUIRE(count == 1);
+    }
+
+    SECTION("runs consecutive batches") {
+        auto sum = std::atomic<int>(0);
+        for (auto batch = 0; batch < 100; batch++) {
+            pool.parallel_for(batch, [&](int i) { sum += i; });
+        }
+        // Sum of (n - 1) * n / 2 for n from 0 to 99
+        REQUIRE(sum == 161700);
+    }
+
+    SECTION("balances uneven tasks") {
+        // Tasks 0 and 1 are queued to the same thread. The task that starts
+        // first blocks its thread until the other one is done, so the other
+        // one can only be completed when it is stolen by another thread.
+        auto other_done = std::promise<void>();
+        auto started = std::atomic<int>(0);
+        auto threads = std::vector<std::thread::id>(8);
+        pool.parallel_for(8, [&](int i) {
+            threads[i] = std::this_thread::get_id();
+            if (i >= 2) return;
+            if (started++ == 0) {
+                other_done.get_future().wait();
+            } else {
+                other_done.set_value();
+            }
+        });
+        REQUIRE(threads[0] != threads[1]);
+    }
+}